@@ -0,0 +1,385 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmarks of the library, printing their results as JSON in the format of
+ * Google Benchmark, so that the results can be compared by its tools.
+ *
+ * Usage: editorconfig_bench [--filter SUBSTRING] [--min-time SECONDS]
+ *                           [--out FILE]
+ *
+ * The micro benchmarks time the glob matching, the INI parser and
+ * editorconfig_parse() on a small tree. The macro benchmarks resolve all the
+ * files of synthetic trees generated in a temporary directory. The parsed
+ * EditorConfig files are cached by the library, thus the benchmarks measure
+ * the resolution with a warm cache.
+ */
+
+#include "global.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <editorconfig/editorconfig.h>
+
+#include "ec_glob.h"
+#include "ini.h"
+
+#include "synth_tree.h"
+
+#ifndef EC_BENCH_GLOB_ENGINE
+# define EC_BENCH_GLOB_ENGINE   "native"
+#endif
+
+/* the options */
+static const char*      filter;
+static double           min_time = 0.5;
+
+/* whether a benchmark has been printed, to separate the JSON objects */
+static _Bool            printed_any;
+
+typedef void (*bench_func)(long iterations, void* arg);
+
+static double now(void)
+{
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * Run func with more and more iterations until it takes min_time, then print
+ * its result. items and bytes are the counts processed by one iteration, or 0.
+ */
+static void run_bench(const char* name, bench_func func, void* arg,
+        double items, double bytes)
+{
+    long                iterations = 1;
+    double              elapsed;
+
+    if (filter && !strstr(name, filter))
+        return;
+
+    for (;;) {
+        double          start = now();
+        double          scale;
+
+        func(iterations, arg);
+        elapsed = now() - start;
+        if (elapsed >= min_time || iterations >= 1000000000L)
+            break;
+
+        /* aim a bit above min_time, growing at most tenfold */
+        scale = elapsed > 0 ? 1.4 * min_time / elapsed : 10;
+        if (scale > 10)
+            scale = 10;
+        if (scale < 1.5)
+            scale = 1.5;
+        iterations = (long)(iterations * scale);
+    }
+
+    printf("%s\n    {\n", printed_any ? "," : "");
+    printf("      \"name\": \"%s\",\n", name);
+    printf("      \"iterations\": %ld,\n", iterations);
+    printf("      \"real_time\": %.3f,\n", elapsed * 1e9 / iterations);
+    printf("      \"time_unit\": \"ns\"");
+    if (items > 0)
+        printf(",\n      \"items_per_second\": %.1f",
+                items * iterations / elapsed);
+    if (bytes > 0)
+        printf(",\n      \"bytes_per_second\": %.1f",
+                bytes * iterations / elapsed);
+    printf("\n    }");
+    fflush(stdout);
+    printed_any = 1;
+}
+
+/* ec_glob() benchmarks */
+
+typedef struct
+{
+    const char*         pattern;
+    const char*         string;
+} glob_case;
+
+static void bench_glob(long iterations, void* arg)
+{
+    const glob_case*    gc = (const glob_case*)arg;
+    long                i;
+
+    for (i = 0; i < iterations; ++i)
+        ec_glob(gc->pattern, gc->string);
+}
+
+static void run_glob_benches(void)
+{
+    static const struct
+    {
+        const char*     name;
+        glob_case       gc;
+    } cases[] =
+    {
+        { "glob/literal",
+            { "/home/user/project/src/main.c",
+                "/home/user/project/src/main.c" } },
+        { "glob/star",
+            { "/home/user/project/src/*.c",
+                "/home/user/project/src/main.c" } },
+        { "glob/double_star",
+            { "/home/user/project/**/test_*.c",
+                "/home/user/project/src/lib/tests/unit/test_parser.c" } },
+        { "glob/braces",
+            { "/home/user/project/**/*.{c,h,cpp,hpp,cc,hh}",
+                "/home/user/project/src/lib/parser.hh" } },
+        { "glob/numeric_range",
+            { "/home/user/project/logs/file{1..100}.txt",
+                "/home/user/project/logs/file57.txt" } },
+        { "glob/bracket",
+            { "/home/user/project/**/[a-m]*.[ch]",
+                "/home/user/project/src/lib/glob.h" } },
+        { "glob/mismatch",
+            { "/home/user/project/**/*.{c,h}",
+                "/home/user/project/src/lib/parser.py" } }
+    };
+    int                 i;
+
+    for (i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); ++i)
+        run_bench(cases[i].name, bench_glob, (void*)&cases[i].gc, 1, 0);
+}
+
+/* ini_parse_file() benchmarks */
+
+static int count_handler(void* user, const char* section, const char* name,
+        const char* value)
+{
+    (void)section;
+    (void)name;
+    (void)value;
+    ++ *(long*)user;
+    return 1;
+}
+
+static void bench_ini(long iterations, void* arg)
+{
+    FILE*               file = (FILE*)arg;
+    long                pairs = 0;
+    long                i;
+
+    for (i = 0; i < iterations; ++i) {
+        rewind(file);
+        ini_parse_file(file, count_handler, &pairs);
+    }
+}
+
+static void run_ini_benches(const char* tmp_dir)
+{
+    static const int    line_counts[] = { 10, 100, 1000, 10000 };
+    char                path[4096];
+    char                name[64];
+    int                 i;
+    int                 j;
+
+    sprintf(path, "%s/bench.ini", tmp_dir);
+    for (i = 0; i < (int)(sizeof(line_counts) / sizeof(line_counts[0]));
+            ++i) {
+        FILE*           file = fopen(path, "w+");
+        long            size;
+
+        if (!file)
+            return;
+
+        /* a section every ten lines, the other lines are properties */
+        for (j = 0; j < line_counts[i]; ++j) {
+            if (j % 10 == 0)
+                fprintf(file, "[*.{c,h,ext%d}]\n", j);
+            else
+                fprintf(file, "property_%d = value %d\n", j % 10, j);
+        }
+        fflush(file);
+        size = ftell(file);
+
+        sprintf(name, "ini/lines:%d", line_counts[i]);
+        run_bench(name, bench_ini, file, line_counts[i], (double)size);
+        fclose(file);
+        remove(path);
+    }
+}
+
+/* editorconfig_parse() benchmarks */
+
+typedef struct
+{
+    char**              files;
+    int                 file_count;
+    editorconfig_handle handle;
+} parse_case;
+
+static void bench_parse(long iterations, void* arg)
+{
+    parse_case*         pc = (parse_case*)arg;
+    long                i;
+
+    for (i = 0; i < iterations; ++i)
+        editorconfig_parse(pc->files[i % pc->file_count], pc->handle);
+}
+
+static void bench_parse_tree(long iterations, void* arg)
+{
+    parse_case*         pc = (parse_case*)arg;
+    long                i;
+    int                 j;
+
+    for (i = 0; i < iterations; ++i)
+        for (j = 0; j < pc->file_count; ++j)
+            editorconfig_parse(pc->files[j], pc->handle);
+}
+
+static void bench_parse_many(long iterations, void* arg)
+{
+    parse_case*         pc = (parse_case*)arg;
+    editorconfig_handle* handles;
+    long                i;
+    int                 j;
+
+    handles = (editorconfig_handle*)malloc(
+            pc->file_count * sizeof(editorconfig_handle));
+    if (!handles)
+        return;
+    for (j = 0; j < pc->file_count; ++j)
+        handles[j] = editorconfig_handle_init();
+
+    for (i = 0; i < iterations; ++i)
+        editorconfig_parse_many((const char* const*)pc->files,
+                pc->file_count, handles, NULL);
+
+    for (j = 0; j < pc->file_count; ++j)
+        editorconfig_handle_destroy(handles[j]);
+    free(handles);
+}
+
+static void run_tree_benches(const char* tmp_dir)
+{
+    static const struct
+    {
+        const char*         name;
+        synth_tree_params   params;
+    } trees[] =
+    {
+        /* depth, fanout, files, config %, root %, sections, seed */
+        { "d2_f16",  { 2, 16, 4, 50, 0, 8, 1 } },
+        { "d4_f4",   { 4, 4, 4, 50, 10, 8, 2 } },
+        { "d8_f2",   { 8, 2, 4, 30, 0, 16, 3 } }
+    };
+    int                 i;
+
+    for (i = 0; i < (int)(sizeof(trees) / sizeof(trees[0])); ++i) {
+        synth_tree      tree;
+        parse_case      pc;
+        char            name[128];
+
+        if (synth_tree_create(&tree, tmp_dir, &trees[i].params) != 0) {
+            fprintf(stderr, "Failed to generate the tree %s.\n",
+                    trees[i].name);
+            continue;
+        }
+
+        pc.files = tree.files;
+        pc.file_count = tree.file_count;
+        pc.handle = editorconfig_handle_init();
+
+        sprintf(name, "parse/%s", trees[i].name);
+        run_bench(name, bench_parse, &pc, 1, 0);
+        sprintf(name, "tree/%s/parse", trees[i].name);
+        run_bench(name, bench_parse_tree, &pc, tree.file_count, 0);
+        sprintf(name, "tree/%s/parse_many", trees[i].name);
+        run_bench(name, bench_parse_many, &pc, tree.file_count, 0);
+
+        editorconfig_handle_destroy(pc.handle);
+        synth_tree_remove(&tree);
+        synth_tree_free(&tree);
+    }
+}
+
+static void usage(FILE* stream, const char* command)
+{
+    fprintf(stream, "Usage: %s [--filter SUBSTRING] [--min-time SECONDS] "
+            "[--out FILE]\n", command);
+}
+
+int main(int argc, const char* argv[])
+{
+    char                tmp_dir[4096];
+    const char*         tmp_env = getenv("TMPDIR");
+    int                 major;
+    int                 minor;
+    int                 patch;
+    char                date[64];
+    time_t              t = time(NULL);
+    int                 i;
+
+    for (i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            filter = argv[++i];
+        else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+            min_time = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) {
+            if (!freopen(argv[++i], "w", stdout)) {
+                perror(argv[i]);
+                return 1;
+            }
+        } else {
+            usage(stderr, argv[0]);
+            return 1;
+        }
+    }
+
+    sprintf(tmp_dir, "%.4000s/editorconfig-bench.XXXXXX",
+            tmp_env && *tmp_env ? tmp_env : "/tmp");
+    if (!mkdtemp(tmp_dir)) {
+        perror("Failed to create a temporary directory");
+        return 1;
+    }
+
+    editorconfig_get_version(&major, &minor, &patch);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&t));
+    printf("{\n  \"context\": {\n");
+    printf("    \"date\": \"%s\",\n", date);
+    printf("    \"library_version\": \"%d.%d.%d%s\",\n", major, minor, patch,
+            editorconfig_get_version_suffix());
+    printf("    \"glob_engine\": \"%s\",\n", EC_BENCH_GLOB_ENGINE);
+    printf("    \"min_time\": %g\n", min_time);
+    printf("  },\n  \"benchmarks\": [");
+
+    run_glob_benches();
+    run_ini_benches(tmp_dir);
+    run_tree_benches(tmp_dir);
+
+    printf("\n  ]\n}\n");
+
+    rmdir(tmp_dir);
+    return 0;
+}
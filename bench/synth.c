@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Generator of large synthetic trees for scaling tests.
+ *
+ * Usage: editorconfig_synth [OPTIONS] DIR
+ *        editorconfig_synth --scale [OPTIONS]
+ *
+ * The first form generates a tree in DIR and prints the paths of its files.
+ * The second form generates trees of depth 1 up to the given depth in a
+ * temporary directory, resolves every file of them with editorconfig_parse()
+ * and reports the percentiles of the latency of each call. It fails if any
+ * file fails to resolve.
+ */
+
+#include "global.h"
+
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <editorconfig/editorconfig.h>
+
+#include "synth_tree.h"
+
+static double now(void)
+{
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int compare_doubles(const void* a, const void* b)
+{
+    double              x = *(const double*)a;
+    double              y = *(const double*)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* The pth percentile of sorted values, by the nearest rank method */
+static double percentile(const double* sorted, int count, int p)
+{
+    int                 rank = (p * count + 99) / 100;
+
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+/*
+ * Resolve every file of the tree once, storing the latency of each file in
+ * latencies. Return the count of files which fail to resolve.
+ */
+static int resolve_tree(const synth_tree* tree, editorconfig_handle handle,
+        double* latencies)
+{
+    int                 failures = 0;
+    int                 i;
+
+    for (i = 0; i < tree->file_count; ++i) {
+        double          start = now();
+        int             err_num = editorconfig_parse(tree->files[i], handle);
+
+        latencies[i] = now() - start;
+        if (err_num != 0) {
+            fprintf(stderr, "Failed to resolve \"%s\": %s.\n",
+                    tree->files[i], editorconfig_get_error_msg(err_num));
+            ++ failures;
+        }
+    }
+
+    qsort(latencies, tree->file_count, sizeof(double), compare_doubles);
+    return failures;
+}
+
+static void print_latencies(int depth, const synth_tree* tree,
+        const char* pass, const double* sorted)
+{
+    int                 count = tree->file_count;
+
+    printf("%5d %7d %7d %7d  %-5s %9.1f %9.1f %9.1f %9.1f\n", depth,
+            tree->created_count - tree->config_count, tree->config_count,
+            count, pass, percentile(sorted, count, 50) * 1e6,
+            percentile(sorted, count, 90) * 1e6,
+            percentile(sorted, count, 99) * 1e6,
+            sorted[count - 1] * 1e6);
+}
+
+/*
+ * Run the scaling test in a temporary directory, with trees of depth 1 up to
+ * params->depth. The first pass over a tree reads its EditorConfig files, the
+ * second one finds them in the cache of the library.
+ */
+static int run_scaling(const synth_tree_params* params)
+{
+    char                tmp_dir[4096];
+    const char*         tmp_env = getenv("TMPDIR");
+    editorconfig_handle handle;
+    int                 failures = 0;
+    int                 depth;
+
+    sprintf(tmp_dir, "%.4000s/editorconfig-synth.XXXXXX",
+            tmp_env && *tmp_env ? tmp_env : "/tmp");
+    if (!mkdtemp(tmp_dir)) {
+        perror("Failed to create a temporary directory");
+        return 1;
+    }
+
+    handle = editorconfig_handle_init();
+    if (!handle) {
+        rmdir(tmp_dir);
+        return 1;
+    }
+
+    printf("Latency per file in microseconds, fanout %d, %d files per "
+            "directory,\n%d sections per EditorConfig file, seed %lu.\n\n",
+            params->fanout, params->files_per_dir, params->sections,
+            params->seed);
+    printf("depth    dirs configs   files  pass        p50       p90"
+            "       p99       max\n");
+
+    for (depth = 1; depth <= params->depth; ++depth) {
+        synth_tree_params   level_params = *params;
+        synth_tree          tree;
+        double*             latencies;
+
+        level_params.depth = depth;
+        if (synth_tree_create(&tree, tmp_dir, &level_params) != 0) {
+            fprintf(stderr, "Failed to generate a tree of depth %d.\n",
+                    depth);
+            ++ failures;
+            break;
+        }
+
+        latencies = (double*)malloc(tree.file_count * sizeof(double));
+        if (!latencies) {
+            ++ failures;
+        } else {
+            failures += resolve_tree(&tree, handle, latencies);
+            print_latencies(depth, &tree, "cold", latencies);
+            failures += resolve_tree(&tree, handle, latencies);
+            print_latencies(depth, &tree, "warm", latencies);
+            free(latencies);
+        }
+
+        synth_tree_remove(&tree);
+        synth_tree_free(&tree);
+    }
+
+    editorconfig_handle_destroy(handle);
+    rmdir(tmp_dir);
+
+    return failures ? 1 : 0;
+}
+
+/* Create an empty file at each file path of the tree */
+static int touch_files(const synth_tree* tree)
+{
+    int                 i;
+
+    for (i = 0; i < tree->file_count; ++i) {
+        FILE*           file = fopen(tree->files[i], "w");
+
+        if (!file) {
+            perror(tree->files[i]);
+            return -1;
+        }
+        fclose(file);
+    }
+
+    return 0;
+}
+
+static void usage(FILE* stream, const char* command)
+{
+    fprintf(stream, "Usage: %s [OPTIONS] DIR\n", command);
+    fprintf(stream, "       %s --scale [OPTIONS]\n\n", command);
+    fprintf(stream, "Generate a synthetic tree with EditorConfig files in the empty directory\nDIR and print the paths of its files, or run the scaling test.\n\n");
+    fprintf(stream, "-d DEPTH           Count of directory levels (default 4).\n");
+    fprintf(stream, "-n FANOUT          Count of subdirectories of each directory (default 4).\n");
+    fprintf(stream, "-p FILES           Count of files in each directory (default 4).\n");
+    fprintf(stream, "-c PERCENT         Directories with an EditorConfig file (default 50).\n");
+    fprintf(stream, "-r PERCENT         EditorConfig files with root = true (default 10).\n");
+    fprintf(stream, "-s SECTIONS        Count of sections of each EditorConfig file (default 100).\n");
+    fprintf(stream, "-S SEED            Seed of the generator (default 1).\n");
+    fprintf(stream, "-t                 Create the files themselves, empty.\n");
+    fprintf(stream, "--scale            Run the scaling test with trees of depth 1 to DEPTH.\n");
+    fprintf(stream, "-h OR --help       Print this help message.\n");
+}
+
+int main(int argc, const char* argv[])
+{
+    synth_tree_params   params = { 4, 4, 4, 50, 10, 100, 1 };
+    const char*         dir = NULL;
+    char                full_dir[PATH_MAX];
+    int                 scale = 0;
+    int                 touch = 0;
+    synth_tree          tree;
+    int                 i;
+
+    for (i = 1; i < argc; ++i) {
+        const char*     value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (!strcmp(argv[i], "--scale"))
+            scale = 1;
+        else if (!strcmp(argv[i], "-t"))
+            touch = 1;
+        else if (!strcmp(argv[i], "-h") || !strcmp(argv[i], "--help")) {
+            usage(stdout, argv[0]);
+            return 0;
+        } else if (value && !strcmp(argv[i], "-d"))
+            params.depth = atoi(argv[++i]);
+        else if (value && !strcmp(argv[i], "-n"))
+            params.fanout = atoi(argv[++i]);
+        else if (value && !strcmp(argv[i], "-p"))
+            params.files_per_dir = atoi(argv[++i]);
+        else if (value && !strcmp(argv[i], "-c"))
+            params.config_percent = atoi(argv[++i]);
+        else if (value && !strcmp(argv[i], "-r"))
+            params.root_percent = atoi(argv[++i]);
+        else if (value && !strcmp(argv[i], "-s"))
+            params.sections = atoi(argv[++i]);
+        else if (value && !strcmp(argv[i], "-S"))
+            params.seed = strtoul(argv[++i], NULL, 10);
+        else if (argv[i][0] != '-' && !dir)
+            dir = argv[i];
+        else {
+            usage(stderr, argv[0]);
+            return 1;
+        }
+    }
+
+    if (params.depth < 0 || params.fanout < 1 || params.files_per_dir < 1 ||
+            params.sections < 0) {
+        fprintf(stderr, "Invalid tree parameters.\n");
+        return 1;
+    }
+
+    if (scale && !dir)
+        return run_scaling(&params);
+
+    if (scale || !dir) {
+        usage(stderr, argv[0]);
+        return 1;
+    }
+
+    /* EditorConfig needs full paths */
+    if (!realpath(dir, full_dir)) {
+        perror(dir);
+        return 1;
+    }
+
+    if (synth_tree_create(&tree, full_dir, &params) != 0) {
+        fprintf(stderr, "Failed to generate the tree in \"%s\".\n", dir);
+        return 1;
+    }
+    if (touch && touch_files(&tree) != 0) {
+        synth_tree_free(&tree);
+        return 1;
+    }
+    for (i = 0; i < tree.file_count; ++i)
+        printf("%s\n", tree.files[i]);
+    synth_tree_free(&tree);
+
+    return 0;
+}
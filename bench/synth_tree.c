@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "synth_tree.h"
+
+static const char* const extensions[] =
+{
+    "c", "h", "py", "js", "md", "txt", "cpp", "java"
+};
+#define EXTENSION_COUNT ((int)(sizeof(extensions) / sizeof(extensions[0])))
+
+/* the properties and their possible values, separated by '|' */
+static const char* const properties[][2] =
+{
+    { "indent_style", "space|tab" },
+    { "indent_size", "2|4|8|tab" },
+    { "tab_width", "4|8" },
+    { "end_of_line", "lf|crlf|cr" },
+    { "charset", "utf-8|latin1|utf-8-bom" },
+    { "trim_trailing_whitespace", "true|false" },
+    { "insert_final_newline", "true|false" },
+    { "max_line_length", "80|100|120|off" }
+};
+#define PROPERTY_COUNT ((int)(sizeof(properties) / sizeof(properties[0])))
+
+/* count of the custom properties, named like linter settings */
+#define CUSTOM_PROPERTY_COUNT   40
+
+/* Buffer size of a path in the tree */
+#define PATH_SIZE               4096
+
+typedef struct
+{
+    synth_tree*             tree;
+    const synth_tree_params* params;
+    /* xorshift state, never 0 */
+    unsigned long           random;
+    int                     files_capacity;
+    int                     created_capacity;
+} synth_context;
+
+/* xorshift32, so that the trees are the same on every platform */
+static unsigned long synth_random(synth_context* ctx, unsigned long range)
+{
+    unsigned long           x = ctx->random;
+
+    x ^= (x << 13) & 0xffffffffUL;
+    x ^= x >> 17;
+    x ^= (x << 5) & 0xffffffffUL;
+    ctx->random = x;
+
+    return x % range;
+}
+
+/* Append a copy of str to an array of strings. Return -1 on failure. */
+static int append_string(char*** array, int* count, int* capacity,
+        const char* str)
+{
+    if (*count == *capacity) {
+        int         new_capacity = *capacity ? 2 * *capacity : 256;
+        char**      new_array;
+
+        new_array = (char**)realloc(*array, new_capacity * sizeof(char*));
+        if (!new_array)
+            return -1;
+        *array = new_array;
+        *capacity = new_capacity;
+    }
+
+    (*array)[*count] = strdup(str);
+    if (!(*array)[*count])
+        return -1;
+    ++ *count;
+
+    return 0;
+}
+
+/* Write the value number n of the '|' separated values into file */
+static void write_value(FILE* file, const char* values, unsigned long n)
+{
+    const char*             end;
+
+    for (; n > 0; -- n)
+        values = strchr(values, '|') + 1;
+    end = strchr(values, '|');
+    fprintf(file, "%.*s", end ? (int)(end - values) : (int)strlen(values),
+            values);
+}
+
+static unsigned long count_values(const char* values)
+{
+    unsigned long           count = 1;
+
+    for (; *values; ++values)
+        if (*values == '|')
+            ++ count;
+    return count;
+}
+
+/* Write the header of a random section, using all kinds of globs */
+static void write_section_header(synth_context* ctx, FILE* file)
+{
+    const synth_tree_params* params = ctx->params;
+    const char*             ext = extensions[synth_random(ctx,
+            EXTENSION_COUNT)];
+
+    switch (synth_random(ctx, 8)) {
+    case 0:
+        fprintf(file, "[*]\n");
+        break;
+    case 1:
+        fprintf(file, "[*.{%s,%s,%s}]\n", ext,
+                extensions[synth_random(ctx, EXTENSION_COUNT)],
+                extensions[synth_random(ctx, EXTENSION_COUNT)]);
+        break;
+    case 2:
+        fprintf(file, "[*.%s]\n", ext);
+        break;
+    case 3:
+        fprintf(file, "[file{%lu..%lu}.%s]\n",
+                synth_random(ctx, params->files_per_dir + 1),
+                synth_random(ctx, 2 * params->files_per_dir + 1), ext);
+        break;
+    case 4:
+        fprintf(file, "[**/d%lu/**.%s]\n",
+                synth_random(ctx, params->fanout + 1), ext);
+        break;
+    case 5:
+        fprintf(file, "[{d%lu,d%lu}/**]\n",
+                synth_random(ctx, params->fanout + 1),
+                synth_random(ctx, params->fanout + 1));
+        break;
+    case 6:
+        fprintf(file, "[*.[ch]]\n");
+        break;
+    default:
+        fprintf(file, "[/d%lu/file?.%s]\n",
+                synth_random(ctx, params->fanout + 1), ext);
+        break;
+    }
+}
+
+/* Write an EditorConfig file at path. Return -1 on failure. */
+static int write_config(synth_context* ctx, const char* path, int is_root)
+{
+    FILE*                   file;
+    int                     i;
+    int                     j;
+
+    file = fopen(path, "w");
+    if (!file)
+        return -1;
+
+    if (is_root || synth_random(ctx, 100) <
+            (unsigned long)ctx->params->root_percent)
+        fprintf(file, "root = true\n\n");
+
+    for (i = 0; i < ctx->params->sections; ++i) {
+        int                 property_count = 1 + (int)synth_random(ctx, 4);
+
+        write_section_header(ctx, file);
+        for (j = 0; j < property_count; ++j) {
+            unsigned long   n = synth_random(ctx,
+                    PROPERTY_COUNT + CUSTOM_PROPERTY_COUNT);
+
+            if (n < PROPERTY_COUNT) {
+                fprintf(file, "%s = ", properties[n][0]);
+                write_value(file, properties[n][1], synth_random(ctx,
+                            count_values(properties[n][1])));
+                fprintf(file, "\n");
+            } else
+                fprintf(file, "lint_rule_%lu = %s\n", n - PROPERTY_COUNT,
+                        synth_random(ctx, 2) ? "on" : "off");
+        }
+        fprintf(file, "\n");
+    }
+
+    if (fclose(file) != 0)
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Fill the directory at path, of size len, which is at the given level of
+ * the tree. Return -1 on failure.
+ */
+static int fill_dir(synth_context* ctx, char* path, size_t len, int level)
+{
+    synth_tree*             tree = ctx->tree;
+    const synth_tree_params* params = ctx->params;
+    int                     i;
+
+    if (len + 64 >= PATH_SIZE)
+        return -1;
+
+    if (level == 0 || synth_random(ctx, 100) <
+            (unsigned long)params->config_percent) {
+        sprintf(path + len, "/.editorconfig");
+        if (write_config(ctx, path, level == 0) != 0 ||
+                append_string(&tree->created, &tree->created_count,
+                    &ctx->created_capacity, path) != 0)
+            return -1;
+        ++ tree->config_count;
+    }
+
+    for (i = 0; i < params->files_per_dir; ++i) {
+        sprintf(path + len, "/file%d.%s", i,
+                extensions[synth_random(ctx, EXTENSION_COUNT)]);
+        if (append_string(&tree->files, &tree->file_count,
+                    &ctx->files_capacity, path) != 0)
+            return -1;
+    }
+
+    if (level == params->depth)
+        return 0;
+
+    for (i = 0; i < params->fanout; ++i) {
+        size_t              sub_len = len + sprintf(path + len, "/d%d", i);
+
+        if (mkdir(path, 0755) != 0 ||
+                append_string(&tree->created, &tree->created_count,
+                    &ctx->created_capacity, path) != 0 ||
+                fill_dir(ctx, path, sub_len, level + 1) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+int synth_tree_create(synth_tree* tree, const char* root,
+        const synth_tree_params* params)
+{
+    synth_context           ctx;
+    char                    path[PATH_SIZE];
+
+    memset(tree, 0, sizeof(synth_tree));
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.tree = tree;
+    ctx.params = params;
+    ctx.random = (params->seed & 0xffffffffUL) ^ 0x9e3779b9UL;
+    if (ctx.random == 0)
+        ctx.random = 1;
+
+    if (strlen(root) >= PATH_SIZE / 2)
+        return -1;
+    strcpy(path, root);
+    tree->root = strdup(root);
+
+    if (!tree->root || fill_dir(&ctx, path, strlen(path), 0) != 0) {
+        synth_tree_remove(tree);
+        synth_tree_free(tree);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+void synth_tree_remove(const synth_tree* tree)
+{
+    int                     i;
+
+    /* the children are created after their parent */
+    for (i = tree->created_count - 1; i >= 0; --i)
+        remove(tree->created[i]);
+}
+
+/*
+ * See header file
+ */
+void synth_tree_free(synth_tree* tree)
+{
+    int                     i;
+
+    for (i = 0; i < tree->file_count; ++i)
+        free(tree->files[i]);
+    for (i = 0; i < tree->created_count; ++i)
+        free(tree->created[i]);
+    free(tree->files);
+    free(tree->created);
+    free(tree->root);
+    memset(tree, 0, sizeof(synth_tree));
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SYNTH_TREE_H__
+#define __SYNTH_TREE_H__
+
+/*
+ * Generator of synthetic source trees with EditorConfig files at several
+ * levels, used by the benchmarks. A tree is fully determined by its
+ * parameters, including the seed, so that runs are reproducible.
+ */
+
+typedef struct
+{
+    /* count of directory levels below the root of the tree */
+    int                     depth;
+    /* count of subdirectories of each directory above the last level */
+    int                     fanout;
+    /* count of files in each directory */
+    int                     files_per_dir;
+    /* percentage of the directories with an EditorConfig file, the root of
+     * the tree always has one */
+    int                     config_percent;
+    /* percentage of the EditorConfig files below the root with root = true */
+    int                     root_percent;
+    /* count of sections of each EditorConfig file */
+    int                     sections;
+    unsigned long           seed;
+} synth_tree_params;
+
+typedef struct
+{
+    /* the directory the tree is generated in */
+    char*                   root;
+    /* full paths of the files to resolve, which are not created on disk */
+    char**                  files;
+    int                     file_count;
+    /* directories and EditorConfig files created on disk, parents first */
+    char**                  created;
+    int                     created_count;
+    int                     config_count;
+} synth_tree;
+
+/*
+ * Generate a tree described by params in root, which must be an existing
+ * empty directory. Return 0 on success, -1 on failure, in which case the part
+ * of the tree already created is removed.
+ */
+int synth_tree_create(synth_tree* tree, const char* root,
+        const synth_tree_params* params);
+
+/* Remove the directories and files of the tree from disk, but not its root */
+void synth_tree_remove(const synth_tree* tree);
+
+/* Free the memory of the tree */
+void synth_tree_free(synth_tree* tree);
+
+#endif /* !__SYNTH_TREE_H__ */
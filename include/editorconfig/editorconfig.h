@@ -45,6 +45,39 @@
  * reading from stdin (even only one path is read from stdin), the output
  * format would be INI format, instead of the simple "key=value" lines.
  *
+ * With <em>-j</em> N, the files are resolved by N threads and the results
+ * are still printed in the order of the input files. In this mode all the
+ * paths are read from stdin before any result is printed.
+ *
+ * With <em>-i</em> INDEXFILE, the EditorConfig files saved in INDEXFILE are
+ * loaded first, so that only the ones changed since then are read again, and
+ * the EditorConfig files used are saved in INDEXFILE at the end.
+ *
+ * With <em>-0</em> or <em>--null</em>, the paths read from stdin are
+ * separated by NUL characters instead of newlines, as printed by
+ * <tt>find -print0</tt> or <tt>git ls-files -z</tt>, and are taken as is,
+ * without trimming spaces. The result of each file is printed as a record of
+ * NUL terminated fields: the path of the file, its "key=value" pairs, and an
+ * empty field ending the record.
+ *
+ * With <em>--serve</em> SOCKET, no file is resolved: editorconfig listens on
+ * the Unix domain socket SOCKET and resolves the files of its clients until
+ * it is killed, keeping the parsed EditorConfig files, the compiled globs and
+ * the results warm across requests. The results are dropped as soon as inotify
+ * reports a change of an EditorConfig file in their parent directories. With
+ * <em>--client</em> SOCKET, the files are resolved by the server listening on
+ * SOCKET, with the <em>-f</em> and <em>-b</em> options given to the server,
+ * and the results are printed as usual.
+ *
+ * With <em>--tree</em> DIR, the files resolved are all the regular files in
+ * the directory DIR and its subdirectories, found by walking DIR instead of
+ * being given as paths. The results are printed in INI format, or as NUL
+ * separated records with <em>-0</em>, in the order of the directory entries.
+ * With <em>-j</em> N, the subdirectories are walked by N threads and the
+ * files are printed as soon as they are resolved. With <em>--sorted</em>,
+ * the files are printed in the order of their names, directory by directory,
+ * whatever the count of threads.
+ *
  * @htmlonly
  * <table cellpadding="5" cellspacing="5">
  *
@@ -59,6 +92,42 @@
  * </tr>
  *
  * <tr>
+ * <td><em>-j</em></td>
+ * <td>Specify the number of threads resolving the files.</td>
+ * </tr>
+ *
+ * <tr>
+ * <td><em>-i</em></td>
+ * <td>Specify an index file caching the EditorConfig files.</td>
+ * </tr>
+ *
+ * <tr>
+ * <td><em>-0</em> OR <em>--null</em></td>
+ * <td>Read NUL separated paths from stdin, and print NUL separated
+ * records.</td>
+ * </tr>
+ *
+ * <tr>
+ * <td><em>--serve</em> SOCKET</td>
+ * <td>Serve the resolution of files on a Unix domain socket.</td>
+ * </tr>
+ *
+ * <tr>
+ * <td><em>--client</em> SOCKET</td>
+ * <td>Resolve the files with the server listening on SOCKET.</td>
+ * </tr>
+ *
+ * <tr>
+ * <td><em>--tree</em> DIR</td>
+ * <td>Resolve all the files in the directory tree DIR.</td>
+ * </tr>
+ *
+ * <tr>
+ * <td><em>--sorted</em></td>
+ * <td>With --tree, print the files in the order of their names.</td>
+ * </tr>
+ *
+ * <tr>
  * <td><em>-h</em> OR <em>--help</em></td>
  * <td>Print this help message.</td>
  * </tr>
@@ -76,6 +145,22 @@
  *
  * -b             Specify version (used by devs to test compatibility).
  *
+ * -j             Specify the number of threads resolving the files.
+ *
+ * -i             Specify an index file caching the EditorConfig files.
+ *
+ * -0 OR --null   Read NUL separated paths from stdin, and print NUL separated
+ *                records.
+ *
+ * --serve SOCKET Serve the resolution of files on a Unix domain socket.
+ *
+ * --client SOCKET
+ *                Resolve the files with the server listening on SOCKET.
+ *
+ * --tree DIR     Resolve all the files in the directory tree DIR.
+ *
+ * --sorted       With --tree, print the files in the order of their names.
+ *
  * -h OR --help   Print this help message.
  *
  * --version      Display version information.
@@ -219,6 +304,17 @@ extern "C" {
  * function (including the parsing result). The @ref editorconfig_handle should
  * be created by editorconfig_handle_init().
  *
+ * A handle can be used to parse any number of files, one after the other.
+ * Each parse replaces the result of the previous one, which is no longer
+ * valid, including the strings obtained from the handle. The memory of the
+ * previous result is reused, so that parsing again with a handle that has
+ * grown large enough does not allocate memory.
+ *
+ * This function is thread-safe: it can be called concurrently from several
+ * threads, as long as each thread uses a different @ref editorconfig_handle.
+ * The parsed EditorConfig files and compiled patterns cached by the library
+ * are shared between the threads.
+ *
  * @retval 0 Everything is OK.
  *
  * @retval "Positive Integer" A parsing error occurs. The return value would be
@@ -241,9 +337,325 @@ extern "C" {
 EDITORCONFIG_EXPORT
 int editorconfig_parse(const char* full_filename, editorconfig_handle h);
 
+/*!
+ * @brief Parse editorconfig files for several files at once.
+ *
+ * This gives the same results as calling editorconfig_parse() for each
+ * file, but is faster when many files are to be parsed: the EditorConfig
+ * files of each directory are looked up once for all the files in the
+ * directory and in its subdirectories. An EditorConfig file changed on disk
+ * during the call may thus be seen by some of the files only.
+ *
+ * @param full_filenames An array of count full paths of files.
+ *
+ * @param count The count of files in full_filenames.
+ *
+ * @param handles An array of count @ref editorconfig_handle objects, created
+ * by editorconfig_handle_init(). handles[i] is used and filled the same way
+ * as editorconfig_parse() does for full_filenames[i].
+ *
+ * @param err_nums If not null, an array of count integers, where err_nums[i]
+ * is set to the value editorconfig_parse() would return for
+ * full_filenames[i].
+ *
+ * @retval 0 Every file is parsed successfully.
+ *
+ * @retval "Non-zero" The error number of the first file that failed to be
+ * parsed. See editorconfig_parse() for the meaning of the error numbers.
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_parse_many(const char* const* full_filenames, int count,
+        editorconfig_handle* handles, int* err_nums);
+
+/*!
+ * @brief The function called by editorconfig_parse_tree() for each file.
+ *
+ * @param full_filename The full path of the file, or of the directory that
+ * could not be read if err_num is EDITORCONFIG_PARSE_DIR_ERROR. It is only
+ * valid during the call.
+ *
+ * @param err_num The value editorconfig_parse() would return for the file,
+ * or EDITORCONFIG_PARSE_DIR_ERROR.
+ *
+ * @param h The @ref editorconfig_handle given to editorconfig_parse_tree(),
+ * filled the same way as editorconfig_parse() does for the file. It is only
+ * valid during the call.
+ *
+ * @param user_data The pointer given to editorconfig_parse_tree().
+ *
+ * @return 0 to go on with the walk, any other value to stop it.
+ */
+typedef int (*editorconfig_tree_callback)(const char* full_filename,
+        int err_num, editorconfig_handle h, void* user_data);
+
+/*!
+ * @brief Parse editorconfig files for all the files in a directory tree.
+ *
+ * The directory tree is walked, and callback is called for each regular
+ * file in dir and its subdirectories, with the same result as
+ * editorconfig_parse() for the file. Symbolic links are not followed. The
+ * EditorConfig files of each directory are read once, when the walk enters
+ * the directory, and stay in use until it leaves the directory, so that no
+ * file is looked up in the directories above.
+ *
+ * The order of the files is the order of the directory entries. Directories
+ * that cannot be read are reported to callback with
+ * EDITORCONFIG_PARSE_DIR_ERROR, and the walk goes on.
+ *
+ * @param dir The full path of the directory.
+ *
+ * @param h The @ref editorconfig_handle used for each file.
+ *
+ * @param callback The function called for each file.
+ *
+ * @param user_data The last parameter of callback.
+ *
+ * @retval 0 All the files have been visited.
+ *
+ * @retval "Non-zero" The value returned by callback to stop the walk, or
+ * EDITORCONFIG_PARSE_NOT_FULL_PATH, EDITORCONFIG_PARSE_MEMORY_ERROR or
+ * EDITORCONFIG_PARSE_VERSION_TOO_NEW as editorconfig_parse() does, or
+ * EDITORCONFIG_PARSE_DIR_ERROR if dir cannot be read or directories cannot be
+ * walked on this platform.
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_parse_tree(const char* dir, editorconfig_handle h,
+        editorconfig_tree_callback callback, void* user_data);
+
+/*!
+ * editorconfig_parse_tree_parallel() flag: the files are reported in the
+ * order of their names, directory by directory, as a depth first walk
+ * visiting the entries of each directory sorted by name.
+ */
+#define EDITORCONFIG_TREE_SORTED                        1
+
+/*!
+ * @brief Parse editorconfig files for all the files in a directory tree,
+ * with several threads.
+ *
+ * This walks the directory tree as editorconfig_parse_tree() does, but the
+ * subdirectories are walked by jobs threads, one of them being the calling
+ * thread. Each thread walks its subdirectories depth first and takes the
+ * subdirectories queued by the others when it runs out of its own, sharing
+ * the EditorConfig files of the directories above.
+ *
+ * callback is called by the threads one at a time, with a handle of the
+ * calling thread. Without EDITORCONFIG_TREE_SORTED, a file is reported as
+ * soon as it is resolved. With EDITORCONFIG_TREE_SORTED, the order is always
+ * the same, and the results of the files resolved ahead of their turn are
+ * kept in memory until they are reported.
+ *
+ * Where threads are not available, the files are reported by
+ * editorconfig_parse_tree(), in the order of the directory entries.
+ *
+ * @param dir The full path of the directory.
+ *
+ * @param h The @ref editorconfig_handle whose conf file name and version are
+ * used for each file. It is not filled by the call.
+ *
+ * @param jobs The count of threads.
+ *
+ * @param flags 0 or EDITORCONFIG_TREE_SORTED.
+ *
+ * @param callback The function called for each file.
+ *
+ * @param user_data The last parameter of callback.
+ *
+ * @return The same values as editorconfig_parse_tree().
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_parse_tree_parallel(const char* dir, editorconfig_handle h,
+        int jobs, int flags, editorconfig_tree_callback callback,
+        void* user_data);
+
+/*!
+ * @brief A set of EditorConfig files loaded once for a directory tree, and
+ * queried by any number of threads.
+ */
+typedef void*   editorconfig_config_set;
+
+/*!
+ * @brief Load the EditorConfig files of a directory tree into a set.
+ *
+ * The EditorConfig files of dir, of its subdirectories and of the
+ * directories above it are read once, and the set is never changed
+ * afterwards: an EditorConfig file changed on disk is only seen by a new set.
+ * Symbolic links to directories are not followed, and the directories that
+ * cannot be read are left out of the set. Where directories cannot be walked
+ * on this platform, only dir and the directories above it are loaded.
+ *
+ * @param dir The full path of the directory.
+ *
+ * @param conf_file_name The file name of the EditorConfig files, or NULL for
+ * ".editorconfig".
+ *
+ * @return The set, to be destroyed with editorconfig_config_set_destroy(),
+ * or NULL if dir is not a full path or a memory error occurs.
+ */
+EDITORCONFIG_EXPORT
+editorconfig_config_set editorconfig_config_set_new(const char* dir,
+        const char* conf_file_name);
+
+/*!
+ * @brief Get the properties of a file from a set of EditorConfig files.
+ *
+ * This gives the same result as editorconfig_parse() would have given when
+ * the set was loaded. If the directory of full_filename is in the set, no
+ * file is read and no lock is taken. Otherwise the EditorConfig files of the
+ * directory are read for this call only, as editorconfig_parse() does.
+ *
+ * This function is thread-safe: a set can be queried concurrently from
+ * several threads, as long as each thread uses a different
+ * @ref editorconfig_handle.
+ *
+ * @param set The set, created by editorconfig_config_set_new().
+ *
+ * @param full_filename The full path of the file.
+ *
+ * @param h The @ref editorconfig_handle filled with the result, whose version
+ * is used. Its conf file name is not used, the set has its own.
+ *
+ * @return The same values as editorconfig_parse().
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_config_set_query(editorconfig_config_set set,
+        const char* full_filename, editorconfig_handle h);
+
+/*!
+ * @brief Destroy a set of EditorConfig files.
+ *
+ * No query of the set must be running.
+ *
+ * @param set The set, created by editorconfig_config_set_new(), or NULL.
+ */
+EDITORCONFIG_EXPORT
+void editorconfig_config_set_destroy(editorconfig_config_set set);
+
+/*!
+ * @brief Load the EditorConfig files saved in an index file.
+ *
+ * The EditorConfig files parsed by the library are kept in memory, so that
+ * they are not read again as long as they do not change on disk. An index
+ * file saves them for another process: once the index is loaded, a file of
+ * the index is read again only if it has changed since the index was saved.
+ *
+ * @param index_path The path of an index file saved by
+ * editorconfig_index_save().
+ *
+ * @retval 0 The index is loaded successfully.
+ *
+ * @retval -1 The index file cannot be read, is not a valid index, or a memory
+ * error occurs.
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_index_load(const char* index_path);
+
+/*!
+ * @brief Save the EditorConfig files parsed so far into an index file.
+ *
+ * The index file is replaced at once. Nothing is written if the index file
+ * was loaded or saved last and no EditorConfig file has been read since then.
+ *
+ * @param index_path The path of the index file.
+ *
+ * @retval 0 The index is saved successfully.
+ *
+ * @retval -1 The index file cannot be written.
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_index_save(const char* index_path);
+
+/*!
+ * @brief The function called by editorconfig_watch_poll() for each change.
+ *
+ * @param dir The directory whose EditorConfig file changed: the results of
+ * the files in dir and in its subdirectories may have changed. dir is NULL if
+ * the results of any file may have changed.
+ *
+ * @param generation The generation after the change.
+ *
+ * @param user_data The pointer given to editorconfig_watch_set_callback().
+ */
+typedef void (*editorconfig_watch_callback)(const char* dir,
+        unsigned long generation, void* user_data);
+
+/*!
+ * @brief Start watching the EditorConfig files used by the parses.
+ *
+ * Once the watcher is started, every directory visited by
+ * editorconfig_parse(), editorconfig_parse_many() and
+ * editorconfig_config_set_new() is watched with inotify, since an
+ * EditorConfig file can appear in it, and so is every EditorConfig file
+ * found. editorconfig_watch_poll() then tells whether any of them has
+ * changed, so that a long-lived process can cache the results of the parses
+ * instead of parsing the files again, or checking them with stat().
+ *
+ * A result is up to date as long as the generation returned by
+ * editorconfig_watch_poll() is the one returned before the parse. If a
+ * directory or file cannot be watched, for example because the inotify
+ * limits are reached, the next call to editorconfig_watch_poll() reports that
+ * any result may have changed.
+ *
+ * Only the paths are watched: a change of the target of a symbolic link to a
+ * directory is not seen.
+ *
+ * @retval 0 The watcher is started, or was started already.
+ *
+ * @retval -1 inotify is not available.
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_watch_start(void);
+
+/*!
+ * @brief Stop watching the EditorConfig files and remove all the watches.
+ *
+ * The generation is kept, and still returned by editorconfig_watch_poll().
+ */
+EDITORCONFIG_EXPORT
+void editorconfig_watch_stop(void);
+
+/*!
+ * @brief Get the file descriptor of the watcher.
+ *
+ * The file descriptor becomes readable when editorconfig_watch_poll() has
+ * events to handle, so that it can be added to the event loop of the
+ * application. It must not be read or closed.
+ *
+ * @return The file descriptor, or -1 if the watcher is not started.
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_watch_get_fd(void);
+
+/*!
+ * @brief Set the function called by editorconfig_watch_poll() for each change.
+ *
+ * @param callback The function, or NULL to remove it. It is called by the
+ * thread calling editorconfig_watch_poll(), without any lock held, so that it
+ * can call the library.
+ *
+ * @param user_data The last parameter of callback.
+ */
+EDITORCONFIG_EXPORT
+void editorconfig_watch_set_callback(editorconfig_watch_callback callback,
+        void* user_data);
+
+/*!
+ * @brief Handle the pending changes of the watched files.
+ *
+ * The generation is increased by one for each directory whose EditorConfig
+ * file changed, and the callback is called for each of them. The events of a
+ * change are queued by the time the call changing the file returns, thus a
+ * change is always seen by the next call.
+ *
+ * @return The generation, which is 0 until a change is seen.
+ */
+EDITORCONFIG_EXPORT
+unsigned long editorconfig_watch_poll(void);
+
 /*!
  * @brief Get the error message from the error number returned by
- * editorconfig_parse().
+ * editorconfig_parse(), editorconfig_parse_many(), editorconfig_parse_tree()
+ * or editorconfig_config_set_query().
  *
  * An example is available at
  * <a href=https://github.com/editorconfig/editorconfig-core/blob/master/src/bin/main.c>src/bin/main.c</a>
@@ -270,6 +682,10 @@ const char* editorconfig_get_error_msg(int err_num);
  * editorconfig_handle is greater than the current version.
  */
 #define EDITORCONFIG_PARSE_VERSION_TOO_NEW              (-4)
+/*!
+ * editorconfig_parse_tree() return value: a directory cannot be read.
+ */
+#define EDITORCONFIG_PARSE_DIR_ERROR                    (-5)
 
 /*!
  * @brief Get the version number of EditorConfig.
@@ -71,6 +71,23 @@ editorconfig_handle editorconfig_handle_init(void);
 EDITORCONFIG_EXPORT
 int editorconfig_handle_destroy(editorconfig_handle h);
 
+/*!
+ * @brief Clear the result of the last parse of an editorconfig_handle object.
+ *
+ * The name and value fields and the err_file field are cleared, while the
+ * version and conf_file_name fields are kept. The memory of the cleared
+ * fields is not released but kept for the next parse, so that a handle used
+ * for many files stops allocating memory once it has grown large enough.
+ * editorconfig_parse() does this itself, calling this function is only
+ * needed to drop a result earlier.
+ *
+ * @param h The editorconfig_handle object to be cleared.
+ *
+ * @return None.
+ */
+EDITORCONFIG_EXPORT
+void editorconfig_handle_reset(editorconfig_handle h);
+
 /*!
  * @brief Get the err_file field of an editorconfig_handle object
  *
@@ -154,6 +171,31 @@ void editorconfig_handle_set_conf_file_name(editorconfig_handle h,
 EDITORCONFIG_EXPORT
 const char* editorconfig_handle_get_conf_file_name(const editorconfig_handle h);
 
+/*!
+ * @brief Set the properties resolved by the parses with an
+ * editorconfig_handle object.
+ *
+ * By default, a parse resolves all the properties. Once the properties are
+ * set, the result of a parse only has the properties named in names, with
+ * the values they would have in the full result. The sections of the
+ * EditorConfig files that set none of them are not matched against the file,
+ * and the other properties are not stored.
+ *
+ * @param h The editorconfig_handle object.
+ *
+ * @param names The names of the properties, case insensitive, or NULL to
+ * resolve all the properties again. The names are copied.
+ *
+ * @param count The count of names.
+ *
+ * @retval 0 The properties are set.
+ *
+ * @retval -1 A memory error occurs, all the properties are resolved.
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_handle_set_properties(editorconfig_handle h,
+        const char* const* names, int count);
+
 /*!
  * @brief Get the nth name and value fields of an editorconfig_handle object.
  *
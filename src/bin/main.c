@@ -32,6 +32,12 @@
 #include <string.h>
 #include <editorconfig/editorconfig.h>
 
+#include "server.h"
+
+#ifdef CMAKE_USE_PTHREADS_INIT
+# include <pthread.h>
+#endif
+
 
 static void version(FILE* stream)
 {
@@ -53,19 +59,682 @@ static void usage(FILE* stream, const char* command)
     fprintf(stream, "\n");
     fprintf(stream, "-f                 Specify conf filename other than \".editorconfig\".\n");
     fprintf(stream, "-b                 Specify version (used by devs to test compatibility).\n");
+    fprintf(stream, "-j                 Specify the number of threads resolving the files.\n");
+    fprintf(stream, "-i                 Specify an index file caching the EditorConfig files.\n");
+    fprintf(stream, "-0 OR --null       Read NUL separated paths from stdin, and print NUL separated\n");
+    fprintf(stream, "                   records: the path, the name=value pairs and an empty field.\n");
+    fprintf(stream, "--serve SOCKET     Serve the resolution of files on a Unix domain socket.\n");
+    fprintf(stream, "--client SOCKET    Resolve the files with the server listening on SOCKET.\n");
+    fprintf(stream, "--tree DIR         Resolve all the files in the directory tree DIR.\n");
+    fprintf(stream, "--sorted           With --tree, print the files in the order of their names.\n");
     fprintf(stream, "-h OR --help       Print this help message.\n");
     fprintf(stream, "-v OR --version    Display version information.\n");
 }
 
+/* Size of the output buffer, and of the initial buffer of the paths of -0 */
+#define IO_BUFFER_SIZE      (1 << 16)
+
+/*
+ * The output, buffered here so that it is written with few large fwrite()
+ * calls. With -0, the fields are terminated by NUL characters instead of
+ * newlines, and the file paths are not enclosed in brackets.
+ */
+static struct
+{
+    char                data[IO_BUFFER_SIZE];
+    size_t              len;
+    _Bool               null_separated;
+} out;
+
+static void out_flush(void)
+{
+    if (out.len > 0)
+        fwrite(out.data, 1, out.len, stdout);
+    out.len = 0;
+    fflush(stdout);
+}
+
+static void out_write(const char* data, size_t len)
+{
+    if (out.len + len > IO_BUFFER_SIZE) {
+        fwrite(out.data, 1, out.len, stdout);
+        out.len = 0;
+        if (len > IO_BUFFER_SIZE) {
+            fwrite(data, 1, len, stdout);
+            return;
+        }
+    }
+
+    memcpy(out.data + out.len, data, len);
+    out.len += len;
+}
+
+/* Write the field terminator: a newline, or a NUL character with -0 */
+static void out_end_field(void)
+{
+    out_write(out.null_separated ? "" : "\n", 1);
+}
+
+/* Write the line or field introducing the result of a file */
+static void out_write_header(const char* full_filename)
+{
+    if (out.null_separated)
+        out_write(full_filename, strlen(full_filename));
+    else {
+        out_write("[", 1);
+        out_write(full_filename, strlen(full_filename));
+        out_write("]", 1);
+    }
+    out_end_field();
+}
+
+/* Print the error of a file, after the output of the previous files */
+static void print_error(int err_num, const char* err_file)
+{
+    out_flush();
+    fputs(editorconfig_get_error_msg(err_num), stderr);
+    if (err_num > 0)
+        fprintf(stderr, "\"%s\"", err_file);
+    fprintf(stderr, "\n");
+}
+
+/*
+ * The paths read from stdin, line by line, or NUL separated with -0. Unlike
+ * the lines, the NUL separated paths are taken as is, including their leading
+ * and trailing spaces.
+ */
+typedef struct
+{
+    char*               buffer;
+    size_t              size;
+    /* the unread data is between start and end */
+    size_t              start;
+    size_t              end;
+    _Bool               eof;
+} path_reader;
+
+/*
+ * Read the next NUL separated path. The returned path is valid until the next
+ * call. Return NULL at the end of stdin.
+ */
+static char* read_null_separated_path(path_reader* reader)
+{
+    for (;;) {
+        char*           path = reader->buffer + reader->start;
+        char*           nul = (char*) memchr(path, '\0',
+                reader->end - reader->start);
+        size_t          n;
+
+        if (nul) {
+            reader->start = nul + 1 - reader->buffer;
+            if (*path)
+                return path;
+            continue;               /* skip empty paths */
+        }
+
+        if (reader->eof) {
+            if (reader->start == reader->end)
+                return NULL;
+            /* the last path may lack its terminator, there is room for it */
+            reader->buffer[reader->end] = '\0';
+            reader->start = reader->end;
+            return path;
+        }
+
+        /* move the partial path to the front, growing the buffer if it is
+         * full of it */
+        memmove(reader->buffer, path, reader->end - reader->start);
+        reader->end -= reader->start;
+        reader->start = 0;
+        if (reader->end + 1 >= reader->size) {
+            reader->size = reader->size ? 2 * reader->size : IO_BUFFER_SIZE;
+            reader->buffer = (char*) realloc(reader->buffer, reader->size);
+            if (!reader->buffer) {
+                fprintf(stderr, "Error: Out of memory.\n");
+                exit(1);
+            }
+        }
+
+        n = fread(reader->buffer + reader->end, 1,
+                reader->size - reader->end - 1, stdin);
+        if (n == 0) {
+            if (ferror(stdin))
+                perror("Failed to read stdin");
+            reader->eof = 1;
+        }
+        reader->end += n;
+    }
+}
+
+/*
+ * Read the next path from stdin, skipping blank lines. The returned path is
+ * valid until the next call. Return NULL at the end of stdin.
+ */
+static char* read_path(path_reader* reader)
+{
+    if (out.null_separated)
+        return read_null_separated_path(reader);
+
+    if (!reader->buffer) {
+        reader->size = FILENAME_MAX + 1;
+        reader->buffer = (char*) malloc(reader->size);
+        if (!reader->buffer) {
+            fprintf(stderr, "Error: Out of memory.\n");
+            exit(1);
+        }
+    }
+
+    while (fgets(reader->buffer, (int) reader->size, stdin)) {
+        int             len;
+        char*           full_filename;
+
+        /* trim the trailing space characters */
+        len = strlen(reader->buffer) - 1;
+        while (len >= 0 && isspace(reader->buffer[len]))
+            -- len;
+        if (len < 0) /* we meet a blank line */
+            continue;
+        reader->buffer[len + 1] = '\0';
+
+        full_filename = reader->buffer;
+        while (isspace(*full_filename))
+            ++ full_filename;
+
+        return full_filename;
+    }
+    if (!feof(stdin))
+        perror("Failed to read stdin");
+
+    return NULL;
+}
+
+/*
+ * Write the name=value fields of a parsed handle, and the end of the record
+ * with -0.
+ */
+static void out_write_name_values(editorconfig_handle eh)
+{
+    int             name_value_count;
+    int             j;
+
+    name_value_count = editorconfig_handle_get_name_value_count(eh);
+    for (j = 0; j < name_value_count; ++j) {
+        const char*         name;
+        const char*         value;
+
+        editorconfig_handle_get_name_value(eh, j, &name, &value);
+        out_write(name, strlen(name));
+        out_write("=", 1);
+        out_write(value, strlen(value));
+        out_end_field();
+    }
+
+    if (out.null_separated)
+        out_end_field();
+}
+
+/*
+ * Resolve a file and print its result. With -0, the header is always printed,
+ * since it starts the record of the file.
+ */
+static void resolve_file(editorconfig_handle eh, const char* full_filename,
+        _Bool print_header)
+{
+    int             err_num;
+
+    if (print_header || out.null_separated)
+        out_write_header(full_filename);
+
+    /* parsing the editorconfig files */
+    err_num = editorconfig_parse(full_filename, eh);
+    if (err_num != 0) {
+        print_error(err_num, editorconfig_handle_get_err_file(eh));
+        exit(1);
+    }
+
+    out_write_name_values(eh);
+}
+
+/*
+ * The paths sent to the server in the next request of the client, with
+ * whether the header of each of their results should be printed.
+ */
+typedef struct
+{
+    int                 fd;
+    char*               request;
+    size_t              len;
+    size_t              capacity;
+    _Bool*              print_headers;
+    int                 count;
+    int                 headers_capacity;
+} client_batch;
+
+/* Exit on an unexpected response from the server */
+static void invalid_response(void)
+{
+    out_flush();
+    fprintf(stderr, "Error: Invalid response from the server.\n");
+    exit(1);
+}
+
+/*
+ * Print the result of a file found in the directory tree of --tree. A
+ * directory that cannot be read is skipped with a warning, an error stops the
+ * walk. With -j, this is called by the worker threads one at a time.
+ */
+static int resolve_tree_file(const char* full_filename, int err_num,
+        editorconfig_handle eh, void* user_data)
+{
+    (void)user_data;
+
+    if (err_num == EDITORCONFIG_PARSE_DIR_ERROR) {
+        out_flush();
+        fprintf(stderr, "Warning: Failed to read the directory \"%s\".\n",
+                full_filename);
+        return 0;
+    }
+
+    out_write_header(full_filename);
+    if (err_num != 0) {
+        print_error(err_num, editorconfig_handle_get_err_file(eh));
+        return 1;
+    }
+
+    out_write_name_values(eh);
+    return 0;
+}
+
+/*
+ * Send the paths of the batch to the server, and print the results in its
+ * response
+ */
+static void client_flush(client_batch* batch)
+{
+    char*               response;
+    size_t              len;
+    const char*         field;
+    const char*         end;
+    int                 i;
+
+    if (batch->count == 0)
+        return;
+
+    if (server_send_message(batch->fd, batch->request, batch->len) != 0 ||
+            !(response = server_receive_message(batch->fd, &len))) {
+        out_flush();
+        fprintf(stderr, "Error: Lost the connection to the server.\n");
+        exit(1);
+    }
+
+    /* the response must be a sequence of complete records */
+    if (len > 0 && response[len - 1] != '\0')
+        invalid_response();
+    field = response;
+    end = response + len;
+    for (i = 0; i < batch->count; ++i) {
+        const char*     full_filename = field;
+        int             err_num;
+
+        if (field == end)
+            invalid_response();
+        field += strlen(field) + 1;
+        if (field == end)
+            invalid_response();
+        err_num = atoi(field);
+        field += strlen(field) + 1;
+
+        if (batch->print_headers[i] || out.null_separated)
+            out_write_header(full_filename);
+
+        if (err_num != 0) {
+            print_error(err_num, err_num > 0 && field != end ? field : "");
+            exit(1);
+        }
+
+        /* the name=value fields, up to the empty field ending the record */
+        for (;;) {
+            size_t      field_len;
+
+            if (field == end)
+                invalid_response();
+            field_len = strlen(field);
+            if (field_len == 0)
+                break;
+            out_write(field, field_len);
+            out_end_field();
+            field += field_len + 1;
+        }
+        ++ field;
+        if (out.null_separated)
+            out_end_field();
+    }
+
+    free(response);
+    batch->len = 0;
+    batch->count = 0;
+}
+
+/* Add a path to the batch, sending the batch if it is large enough */
+static void client_add(client_batch* batch, const char* full_filename,
+        _Bool print_header)
+{
+    size_t              len = strlen(full_filename) + 1;
+
+    if (batch->len + len > batch->capacity) {
+        batch->capacity = batch->len + len + IO_BUFFER_SIZE;
+        batch->request = (char*) realloc(batch->request, batch->capacity);
+    }
+    if (batch->count == batch->headers_capacity) {
+        batch->headers_capacity = batch->headers_capacity ?
+            2 * batch->headers_capacity : 1024;
+        batch->print_headers = (_Bool*) realloc(batch->print_headers,
+                batch->headers_capacity * sizeof(_Bool));
+    }
+    if (!batch->request || !batch->print_headers) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        exit(1);
+    }
+
+    memcpy(batch->request + batch->len, full_filename, len);
+    batch->len += len;
+    batch->print_headers[batch->count++] = print_header;
+
+    if (batch->len >= IO_BUFFER_SIZE)
+        client_flush(batch);
+}
+
+/*
+ * Resolve the files with the server listening on socket_path, printing the
+ * results the same way as when resolving them directly
+ */
+static void resolve_files_remote(const char* socket_path, char** file_paths,
+        int path_count)
+{
+    client_batch        batch;
+    path_reader         reader;
+    char*               full_filename;
+    int                 i;
+
+    memset(&batch, 0, sizeof(batch));
+    memset(&reader, 0, sizeof(reader));
+
+    batch.fd = server_connect(socket_path);
+    if (batch.fd < 0) {
+        fprintf(stderr, "Failed to connect to the server at \"%s\".\n",
+                socket_path);
+        exit(1);
+    }
+
+    for (i = 0; i < path_count; ++i) {
+        if (strcmp(file_paths[i], "-"))
+            client_add(&batch, file_paths[i], path_count > 1);
+        else {
+            while ((full_filename = read_path(&reader)))
+                client_add(&batch, full_filename, 1);
+        }
+        free(file_paths[i]);
+    }
+    client_flush(&batch);
+    out_flush();
+
+    server_close(batch.fd);
+    free(batch.request);
+    free(batch.print_headers);
+    free(reader.buffer);
+}
+
+#ifdef CMAKE_USE_PTHREADS_INIT
+/* The result of a file resolved by a worker thread */
+typedef struct
+{
+    char*               full_filename;
+    /* whether the [full_filename] line should be printed */
+    _Bool               print_header;
+    _Bool               is_done;
+    int                 err_num;
+    char*               err_file;
+    /* the name=value fields, terminated by newlines or NUL characters */
+    char*               output;
+    size_t              output_len;
+} file_result;
+
+/* The files shared by the worker threads */
+typedef struct
+{
+    file_result*        results;
+    int                 count;
+    /* index of the next file to be picked by a worker */
+    int                 next;
+    const char*         conf_filename;
+    int                 version_major;
+    int                 version_minor;
+    int                 version_patch;
+    pthread_mutex_t     mutex;
+    pthread_cond_t      done_cond;
+} job_queue;
+
+/*
+ * Format the name=value fields of a parsed handle into a newly allocated
+ * buffer, whose length is stored in output_len.
+ */
+static char* format_name_values(editorconfig_handle eh, size_t* output_len)
+{
+    int             name_value_count;
+    int             j;
+    size_t          len = 1;
+    char*           output;
+    char*           p;
+    const char*     name;
+    const char*     value;
+
+    name_value_count = editorconfig_handle_get_name_value_count(eh);
+    for (j = 0; j < name_value_count; ++j) {
+        editorconfig_handle_get_name_value(eh, j, &name, &value);
+        len += strlen(name) + strlen(value) + 2;
+    }
+
+    output = (char*) malloc(len);
+    if (!output)
+        return NULL;
+
+    p = output;
+    *p = '\0';
+    for (j = 0; j < name_value_count; ++j) {
+        editorconfig_handle_get_name_value(eh, j, &name, &value);
+        p += sprintf(p, "%s=%s", name, value);
+        *p++ = out.null_separated ? '\0' : '\n';
+    }
+    *output_len = p - output;
+
+    return output;
+}
+
+static void* resolve_worker(void* arg)
+{
+    job_queue*          queue = (job_queue*) arg;
+    editorconfig_handle eh;
+
+    /* each worker uses its own handle */
+    eh = editorconfig_handle_init();
+    if (!eh) {
+        fprintf(stderr, "Failed to create editorconfig_handle.\n");
+        exit(1);
+    }
+    if (queue->conf_filename)
+        editorconfig_handle_set_conf_file_name(eh, queue->conf_filename);
+    editorconfig_handle_set_version(eh, queue->version_major,
+            queue->version_minor, queue->version_patch);
+
+    for (;;) {
+        file_result*    result;
+        int             i;
+
+        pthread_mutex_lock(&queue->mutex);
+        i = queue->next++;
+        pthread_mutex_unlock(&queue->mutex);
+
+        if (i >= queue->count)
+            break;
+
+        result = &queue->results[i];
+        result->err_num = editorconfig_parse(result->full_filename, eh);
+        if (result->err_num > 0)
+            result->err_file = strdup(editorconfig_handle_get_err_file(eh));
+        else if (result->err_num == 0) {
+            result->output = format_name_values(eh, &result->output_len);
+            if (!result->output)
+                result->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+        }
+
+        pthread_mutex_lock(&queue->mutex);
+        result->is_done = 1;
+        pthread_cond_broadcast(&queue->done_cond);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+
+    editorconfig_handle_destroy(eh);
+
+    return NULL;
+}
+
+/*
+ * Append a file to the results. Return the new count of results.
+ */
+static int add_file_result(file_result** results, int* capacity, int count,
+        char* full_filename, _Bool print_header)
+{
+    if (count >= *capacity) {
+        *capacity = *capacity ? 2 * *capacity : 64;
+        *results = (file_result*) realloc(*results,
+                *capacity * sizeof(file_result));
+        if (!*results) {
+            fprintf(stderr, "Error: Out of memory.\n");
+            exit(1);
+        }
+    }
+
+    memset(&(*results)[count], 0, sizeof(file_result));
+    (*results)[count].full_filename = full_filename;
+    (*results)[count].print_header = print_header;
+
+    return count + 1;
+}
+
+/*
+ * Resolve the files on jobs worker threads, and print the results in the
+ * order of the input files. The paths read from stdin are all read before
+ * the resolution starts.
+ */
+static void resolve_files_parallel(char** file_paths, int path_count,
+        const char* conf_filename, int version_major, int version_minor,
+        int version_patch, int jobs)
+{
+    job_queue           queue;
+    pthread_t*          threads;
+    int                 capacity = 0;
+    int                 i;
+
+    memset(&queue, 0, sizeof(queue));
+    queue.conf_filename = conf_filename;
+    queue.version_major = version_major;
+    queue.version_minor = version_minor;
+    queue.version_patch = version_patch;
+
+    /* Collect the files, the same way as the serial mode does */
+    for (i = 0; i < path_count; ++i) {
+        path_reader     reader;
+        char*           full_filename;
+
+        if (strcmp(file_paths[i], "-")) {
+            queue.count = add_file_result(&queue.results, &capacity,
+                    queue.count, file_paths[i], path_count > 1);
+            continue;
+        }
+
+        free(file_paths[i]);
+        memset(&reader, 0, sizeof(reader));
+        while ((full_filename = read_path(&reader)))
+            queue.count = add_file_result(&queue.results, &capacity,
+                    queue.count, strdup(full_filename), 1);
+        free(reader.buffer);
+    }
+
+    if (queue.count == 0) {
+        free(queue.results);
+        return;
+    }
+    if (jobs > queue.count)
+        jobs = queue.count;
+
+    pthread_mutex_init(&queue.mutex, NULL);
+    pthread_cond_init(&queue.done_cond, NULL);
+
+    threads = (pthread_t*) malloc(jobs * sizeof(pthread_t));
+    if (!threads) {
+        fprintf(stderr, "Error: Out of memory.\n");
+        exit(1);
+    }
+    for (i = 0; i < jobs; ++i) {
+        if (pthread_create(&threads[i], NULL, resolve_worker, &queue)) {
+            fprintf(stderr, "Failed to create thread.\n");
+            exit(1);
+        }
+    }
+
+    /* Print the results in order as soon as they are available */
+    for (i = 0; i < queue.count; ++i) {
+        file_result*    result = &queue.results[i];
+
+        pthread_mutex_lock(&queue.mutex);
+        while (!result->is_done)
+            pthread_cond_wait(&queue.done_cond, &queue.mutex);
+        pthread_mutex_unlock(&queue.mutex);
+
+        if (result->print_header || out.null_separated)
+            out_write_header(result->full_filename);
+
+        if (result->err_num != 0) {
+            print_error(result->err_num, result->err_file);
+            exit(1);
+        }
+
+        out_write(result->output, result->output_len);
+        if (out.null_separated)
+            out_end_field();
+
+        free(result->output);
+        free(result->full_filename);
+    }
+
+    for (i = 0; i < jobs; ++i)
+        pthread_join(threads[i], NULL);
+
+    pthread_mutex_destroy(&queue.mutex);
+    pthread_cond_destroy(&queue.done_cond);
+    free(threads);
+    free(queue.results);
+}
+#endif /* CMAKE_USE_PTHREADS_INIT */
+
+/*
+ * Save the EditorConfig files used into the index file specified by -i, if
+ * any. Failing to save the index only warns, since the results are right.
+ */
+static void save_index(const char* index_filename)
+{
+    if (index_filename && editorconfig_index_save(index_filename) != 0)
+        fprintf(stderr, "Warning: Failed to save the index file \"%s\".\n",
+                index_filename);
+}
+
 int main(int argc, const char* argv[])
 {
     char*                               full_filename = NULL;
-    int                                 err_num;
     int                                 i;
-    int                                 name_value_count;
     editorconfig_handle                 eh;
     char**                              file_paths = NULL;
-    int                                 path_count; /* the count of path input*/
+    int                                 path_count = 0; /* the count of path input*/
     /* Will be a EditorConfig file name if -f is specified on command line */
     const char*                         conf_filename = NULL;
 
@@ -73,11 +742,29 @@ int main(int argc, const char* argv[])
     int                                 version_minor = -1;
     int                                 version_patch = -1;
 
-    /* File names read from stdin are put in this buffer temporarily */
-    char                                file_line_buffer[FILENAME_MAX + 1];
+    /* count of threads resolving the files, specified by -j */
+    int                                 jobs = 1;
+    /* Will be an index file name if -i is specified on command line */
+    const char*                         index_filename = NULL;
+    /* Will be a socket path if --serve or --client is specified */
+    const char*                         serve_socket = NULL;
+    const char*                         client_socket = NULL;
+    /* Will be a directory if --tree is specified on command line */
+    const char*                         tree_dir = NULL;
+    int                                 err_num;
+
+    /* File names read from stdin are put in its buffer temporarily */
+    path_reader                         reader;
 
     _Bool                               f_flag = 0;
     _Bool                               b_flag = 0;
+    _Bool                               j_flag = 0;
+    _Bool                               i_flag = 0;
+    _Bool                               serve_flag = 0;
+    _Bool                               client_flag = 0;
+    _Bool                               tree_flag = 0;
+    /* whether --sorted is specified */
+    _Bool                               sorted = 0;
 
     if (argc <= 1) {
         version(stderr);
@@ -124,6 +811,25 @@ int main(int argc, const char* argv[])
         } else if (f_flag) {
             f_flag = 0;
             conf_filename = argv[i];
+        } else if (j_flag) {
+            j_flag = 0;
+            jobs = atoi(argv[i]);
+            if (jobs <= 0) {
+                fprintf(stderr, "Invalid number of threads: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (i_flag) {
+            i_flag = 0;
+            index_filename = argv[i];
+        } else if (serve_flag) {
+            serve_flag = 0;
+            serve_socket = argv[i];
+        } else if (client_flag) {
+            client_flag = 0;
+            client_socket = argv[i];
+        } else if (tree_flag) {
+            tree_flag = 0;
+            tree_dir = argv[i];
         } else if (strcmp(argv[i], "--version") == 0 ||
                 strcmp(argv[i], "-v") == 0) {
             version(stdout);
@@ -133,10 +839,25 @@ int main(int argc, const char* argv[])
             version(stdout);
             usage(stdout, argv[0]);
             exit(0);
-        } else if (strcmp(argv[i], "-b") == 0)
+        } else if (strcmp(argv[i], "--null") == 0 ||
+                strcmp(argv[i], "-0") == 0)
+            out.null_separated = 1;
+        else if (strcmp(argv[i], "-b") == 0)
             b_flag = 1;
         else if (strcmp(argv[i], "-f") == 0)
             f_flag = 1;
+        else if (strcmp(argv[i], "-j") == 0)
+            j_flag = 1;
+        else if (strcmp(argv[i], "-i") == 0)
+            i_flag = 1;
+        else if (strcmp(argv[i], "--serve") == 0)
+            serve_flag = 1;
+        else if (strcmp(argv[i], "--client") == 0)
+            client_flag = 1;
+        else if (strcmp(argv[i], "--tree") == 0)
+            tree_flag = 1;
+        else if (strcmp(argv[i], "--sorted") == 0)
+            sorted = 1;
         else if (i < argc) {
             /* If there are other args left, regard them as file names */
 
@@ -156,95 +877,112 @@ int main(int argc, const char* argv[])
         }
     }
 
-    if (!file_paths) { /* No filename is set */ 
+    /* The server resolves files for its clients, it takes no file name */
+    if (serve_socket && !file_paths && !client_socket && !tree_dir) {
+        if (index_filename)
+            editorconfig_index_load(index_filename);
+        exit(server_run(serve_socket, conf_filename,
+                    version_major, version_minor, version_patch));
+    }
+
+    /* Either file names or --tree must be set, not both */
+    if (!file_paths == !tree_dir || serve_socket) {
         usage(stderr, argv[0]);
         exit(1);
     }
 
+    /* The files are resolved with the options of the server */
+    if (client_socket) {
+        if (tree_dir) {
+            fprintf(stderr, "Error: --tree is not supported by the server.\n");
+            exit(1);
+        }
+        if (conf_filename || version_major >= 0 || index_filename) {
+            fprintf(stderr, "Error: -f, -b and -i must be given to the server.\n");
+            exit(1);
+        }
+        resolve_files_remote(client_socket, file_paths, path_count);
+        free(file_paths);
+        exit(0);
+    }
+
+    /* A missing or invalid index is not an error: it is written at the end */
+    if (index_filename)
+        editorconfig_index_load(index_filename);
+
+    if (jobs > 1 && !tree_dir) {
+#ifdef CMAKE_USE_PTHREADS_INIT
+        resolve_files_parallel(file_paths, path_count, conf_filename,
+                version_major, version_minor, version_patch, jobs);
+        out_flush();
+        free(file_paths);
+        save_index(index_filename);
+        exit(0);
+#else
+        fprintf(stderr, "Warning: -j is not supported on this platform.\n");
+#endif
+    }
+
+    /* Initialize the EditorConfig handle, which is reused for all the files */
+    eh = editorconfig_handle_init();
+    if (!eh) {
+        fprintf(stderr, "Failed to create editorconfig_handle.\n");
+        exit(1);
+    }
+
+    /* Set conf file name */
+    if (conf_filename)
+        editorconfig_handle_set_conf_file_name(eh, conf_filename);
+
+    /* Set the version to be compatible with */
+    editorconfig_handle_set_version(eh,
+            version_major, version_minor, version_patch);
+
+    /* Walk the directory tree, printing the result of each file as found.
+     * The errors of the files are printed by resolve_tree_file(). */
+    if (tree_dir) {
+        if (jobs > 1 || sorted)
+            err_num = editorconfig_parse_tree_parallel(tree_dir, eh, jobs,
+                    sorted ? EDITORCONFIG_TREE_SORTED : 0, resolve_tree_file,
+                    NULL);
+        else
+            err_num = editorconfig_parse_tree(tree_dir, eh,
+                    resolve_tree_file, NULL);
+        if (err_num < 0)
+            print_error(err_num, NULL);
+        if (err_num != 0)
+            exit(1);
+    }
+
     /* Go through all the files in the argument list */
+    memset(&reader, 0, sizeof(reader));
     for (i = 0; i < path_count; ++i) {
 
-        int             j;
-
         full_filename = file_paths[i];
 
         /* Print the file path first, with [], if more than one file is
          * specified */
-        if (path_count > 1 && strcmp(full_filename, "-"))
-            printf("[%s]\n", full_filename);
-
-        if (!strcmp(full_filename, "-")) {
-            int             len;
-
-            /* Read a line from stdin. If EOF encountered, continue */
-            if (!fgets(file_line_buffer, FILENAME_MAX + 1, stdin)) {
-                if (!feof(stdin))
-                    perror("Failed to read stdin");
-
-                free(full_filename);
-                continue;
-            }
-
-            -- i;
-
-            /* trim the trailing space characters */
-            len = strlen(file_line_buffer) - 1;
-            while (len >= 0 && isspace(file_line_buffer[len]))
-                -- len;
-            if (len < 0) /* we meet a blank line */
-                continue;
-            file_line_buffer[len + 1] = '\0';
-
-            full_filename = file_line_buffer;
-            while (isspace(*full_filename))
-                ++ full_filename;
-
-            full_filename = strdup(full_filename);
-
-            printf("[%s]\n", full_filename);
+        if (strcmp(full_filename, "-")) {
+            resolve_file(eh, full_filename, path_count > 1);
+            free(full_filename);
+            continue;
         }
 
-        /* Initialize the EditorConfig handle */
-        eh = editorconfig_handle_init();
-
-        /* Set conf file name */
-        if (conf_filename)
-            editorconfig_handle_set_conf_file_name(eh, conf_filename);
-
-        /* Set the version to be compatible with */
-        editorconfig_handle_set_version(eh,
-                version_major, version_minor, version_patch);
-
-        /* parsing the editorconfig files */
-        err_num = editorconfig_parse(full_filename, eh);
+        /* Read the paths from stdin until EOF */
         free(full_filename);
+        while ((full_filename = read_path(&reader)))
+            resolve_file(eh, full_filename, 1);
+    }
+    free(reader.buffer);
+    out_flush();
 
-        if (err_num != 0) {
-            /* print error message */
-            fputs(editorconfig_get_error_msg(err_num), stderr);
-            if (err_num > 0)
-                fprintf(stderr, "\"%s\"", editorconfig_handle_get_err_file(eh));
-            fprintf(stderr, "\n");
-            exit(1);
-        }
-
-        /* print the result */
-        name_value_count = editorconfig_handle_get_name_value_count(eh);
-        for (j = 0; j < name_value_count; ++j) {
-            const char*         name;
-            const char*         value;
-
-            editorconfig_handle_get_name_value(eh, j, &name, &value);
-            printf("%s=%s\n", name, value);
-        }
-
-        if (editorconfig_handle_destroy(eh) != 0) {
-            fprintf(stderr, "Failed to destroy editorconfig_handle.\n");
-            exit(1);
-        }
+    if (editorconfig_handle_destroy(eh) != 0) {
+        fprintf(stderr, "Failed to destroy editorconfig_handle.\n");
+        exit(1);
     }
 
     free(file_paths);
+    save_index(index_filename);
 
     exit(0);
 }
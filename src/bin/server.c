@@ -0,0 +1,655 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <editorconfig/editorconfig.h>
+
+#ifdef HAVE_SYS_UN_H
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <unistd.h>
+#endif
+
+#ifdef CMAKE_USE_PTHREADS_INIT
+# include <pthread.h>
+#endif
+
+#include "server.h"
+
+#ifdef HAVE_SYS_UN_H
+
+/* Max count of results kept by the server, they are all dropped beyond */
+#define SERVER_RESULT_CACHE_SIZE    (1 << 17)
+
+/* A growable buffer */
+typedef struct
+{
+    char*               data;
+    size_t              len;
+    size_t              capacity;
+} buffer;
+
+/* Append data to buf. Return 0 on success, -1 if memory runs out. */
+static int buffer_append(buffer* buf, const char* data, size_t len)
+{
+    if (buf->len + len > buf->capacity) {
+        size_t          capacity = buf->capacity ? buf->capacity : 4096;
+        char*           new_data;
+
+        while (capacity < buf->len + len)
+            capacity *= 2;
+        new_data = (char*) realloc(buf->data, capacity);
+        if (!new_data)
+            return -1;
+        buf->data = new_data;
+        buf->capacity = capacity;
+    }
+
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return 0;
+}
+
+/* Append a NUL terminated field to buf */
+static int buffer_append_field(buffer* buf, const char* field)
+{
+    return buffer_append(buf, field, strlen(field) + 1);
+}
+
+/* A hash table mapping the paths of the resolved files to their records */
+typedef struct map_entry
+{
+    struct map_entry*   next;
+    unsigned int        hash;
+    char*               key;
+    char*               data;
+    size_t              len;
+} map_entry;
+
+typedef struct
+{
+    map_entry**         buckets;
+    size_t              bucket_count;
+    size_t              count;
+} string_map;
+
+static unsigned int str_hash(const char* str)
+{
+    unsigned int        hash = 2166136261u;
+
+    for (; *str; ++str) {
+        hash ^= (unsigned char)*str;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static map_entry* map_find(const string_map* map, const char* key,
+        unsigned int hash)
+{
+    map_entry*          entry;
+
+    if (!map->buckets)
+        return NULL;
+
+    for (entry = map->buckets[hash % map->bucket_count]; entry;
+            entry = entry->next)
+        if (entry->hash == hash && !strcmp(entry->key, key))
+            return entry;
+
+    return NULL;
+}
+
+/*
+ * Add a copy of key, which must not be in the map yet, mapped to data, which
+ * is owned by the map from now on. Return 0 on success, -1 if memory runs
+ * out, in which case data is freed.
+ */
+static int map_add(string_map* map, const char* key, unsigned int hash,
+        char* data, size_t len)
+{
+    map_entry*          entry;
+
+    /* keep at most one entry per bucket on average */
+    if (map->count >= map->bucket_count) {
+        size_t          bucket_count = map->bucket_count ?
+            2 * map->bucket_count : 1024;
+        map_entry**     buckets;
+        size_t          i;
+
+        buckets = (map_entry**) calloc(bucket_count, sizeof(map_entry*));
+        if (!buckets) {
+            free(data);
+            return -1;
+        }
+        for (i = 0; i < map->bucket_count; ++i) {
+            while (map->buckets[i]) {
+                entry = map->buckets[i];
+                map->buckets[i] = entry->next;
+                entry->next = buckets[entry->hash % bucket_count];
+                buckets[entry->hash % bucket_count] = entry;
+            }
+        }
+        free(map->buckets);
+        map->buckets = buckets;
+        map->bucket_count = bucket_count;
+    }
+
+    entry = (map_entry*) malloc(sizeof(map_entry));
+    if (!entry || !(entry->key = strdup(key))) {
+        free(entry);
+        free(data);
+        return -1;
+    }
+    entry->hash = hash;
+    entry->data = data;
+    entry->len = len;
+    entry->next = map->buckets[hash % map->bucket_count];
+    map->buckets[hash % map->bucket_count] = entry;
+    ++ map->count;
+
+    return 0;
+}
+
+/*
+ * Remove the entries of the paths in dir and in its subdirectories, or all
+ * the entries if dir is NULL
+ */
+static void map_remove_dir(string_map* map, const char* dir)
+{
+    /* "/" is the prefix of all the paths, like "" */
+    size_t              dir_len = dir && strcmp(dir, "/") ? strlen(dir) : 0;
+    size_t              i;
+
+    for (i = 0; i < map->bucket_count; ++i) {
+        map_entry**     pp = &map->buckets[i];
+
+        while (*pp) {
+            map_entry*  entry = *pp;
+
+            if (dir && (strncmp(entry->key, dir, dir_len) ||
+                        entry->key[dir_len] != '/')) {
+                pp = &entry->next;
+                continue;
+            }
+            *pp = entry->next;
+            free(entry->key);
+            free(entry->data);
+            free(entry);
+            -- map->count;
+        }
+    }
+}
+
+/*
+ * The state of the server. If the library can watch the EditorConfig files,
+ * the records of the resolved files are cached too, and dropped when the
+ * EditorConfig file of one of their parent directories changes. Otherwise,
+ * only the parsed EditorConfig files and the compiled globs are cached, by
+ * the library.
+ */
+static struct
+{
+    const char*         socket_path;
+    const char*         conf_filename;
+    int                 version_major;
+    int                 version_minor;
+    int                 version_patch;
+    _Bool               watching;
+    string_map          results;
+#ifdef CMAKE_USE_PTHREADS_INIT
+    pthread_mutex_t     mutex;
+#endif
+} server;
+
+static void server_lock(void)
+{
+#ifdef CMAKE_USE_PTHREADS_INIT
+    pthread_mutex_lock(&server.mutex);
+#endif
+}
+
+static void server_unlock(void)
+{
+#ifdef CMAKE_USE_PTHREADS_INIT
+    pthread_mutex_unlock(&server.mutex);
+#endif
+}
+
+/* Called by editorconfig_watch_poll() with the server locked */
+static void drop_results(const char* dir, unsigned long generation,
+        void* user_data)
+{
+    (void) generation;
+    (void) user_data;
+    map_remove_dir(&server.results, dir);
+}
+
+/*
+ * Drop the results changed since the last call, and return the generation of
+ * the watcher they are up to date with. The server must be locked.
+ */
+static unsigned long sync_results(void)
+{
+    return editorconfig_watch_poll();
+}
+
+/* Append the record of a file to buf. Return -1 if memory runs out. */
+static int format_record(buffer* buf, editorconfig_handle eh,
+        const char* full_filename)
+{
+    char                status[16];
+    int                 err_num;
+    int                 name_value_count;
+    int                 j;
+    int                 ret;
+
+    err_num = editorconfig_parse(full_filename, eh);
+    sprintf(status, "%d", err_num);
+    ret = buffer_append_field(buf, full_filename);
+    ret |= buffer_append_field(buf, status);
+
+    if (err_num > 0)
+        ret |= buffer_append_field(buf, editorconfig_handle_get_err_file(eh));
+    else if (err_num == 0) {
+        name_value_count = editorconfig_handle_get_name_value_count(eh);
+        for (j = 0; j < name_value_count; ++j) {
+            const char*         name;
+            const char*         value;
+
+            editorconfig_handle_get_name_value(eh, j, &name, &value);
+            ret |= buffer_append(buf, name, strlen(name));
+            ret |= buffer_append(buf, "=", 1);
+            ret |= buffer_append_field(buf, value);
+        }
+    }
+
+    ret |= buffer_append(buf, "", 1);
+    return ret;
+}
+
+/*
+ * Append the records of the paths of a request to response. Return -1 if the
+ * request is invalid or memory runs out.
+ */
+static int resolve_request(editorconfig_handle eh, const char* request,
+        size_t len, buffer* response, buffer* record)
+{
+    const char*         path;
+
+    if (len > 0 && request[len - 1] != '\0')
+        return -1;
+
+    for (path = request; path < request + len; path += strlen(path) + 1) {
+        unsigned int    hash = str_hash(path);
+        map_entry*      entry;
+        unsigned long   generation;
+
+        server_lock();
+        generation = sync_results();
+        entry = map_find(&server.results, path, hash);
+        if (entry) {
+            int         ret = buffer_append(response, entry->data,
+                    entry->len);
+
+            server_unlock();
+            if (ret != 0)
+                return -1;
+            continue;
+        }
+        server_unlock();
+
+        record->len = 0;
+        if (format_record(record, eh, path) != 0 ||
+                buffer_append(response, record->data, record->len) != 0)
+            return -1;
+
+        if (!server.watching)
+            continue;
+
+        /* the record is cached if nothing changed while resolving it, and
+         * if another connection has not cached it meanwhile */
+        server_lock();
+        if (sync_results() == generation &&
+                !map_find(&server.results, path, hash)) {
+            char*       data = (char*) malloc(record->len);
+
+            if (server.results.count >= SERVER_RESULT_CACHE_SIZE)
+                map_remove_dir(&server.results, NULL);
+            if (data) {
+                memcpy(data, record->data, record->len);
+                map_add(&server.results, path, hash, data, record->len);
+            }
+        }
+        server_unlock();
+    }
+
+    return 0;
+}
+
+/* Serve the requests of a connection until it is closed */
+static void* serve_connection(void* arg)
+{
+    int                 fd = *(int*) arg;
+    editorconfig_handle eh;
+    buffer              response;
+    buffer              record;
+    char*               request;
+    size_t              len;
+
+    free(arg);
+    memset(&response, 0, sizeof(response));
+    memset(&record, 0, sizeof(record));
+
+    eh = editorconfig_handle_init();
+    if (!eh) {
+        close(fd);
+        return NULL;
+    }
+    if (server.conf_filename)
+        editorconfig_handle_set_conf_file_name(eh, server.conf_filename);
+    editorconfig_handle_set_version(eh, server.version_major,
+            server.version_minor, server.version_patch);
+
+    while ((request = server_receive_message(fd, &len))) {
+        response.len = 0;
+        if (resolve_request(eh, request, len, &response, &record) != 0 ||
+                server_send_message(fd, response.data, response.len) != 0) {
+            free(request);
+            break;
+        }
+        free(request);
+    }
+
+    free(response.data);
+    free(record.data);
+    editorconfig_handle_destroy(eh);
+    close(fd);
+
+    return NULL;
+}
+
+/* Remove the socket when the server is stopped */
+static void stop_server(int sig)
+{
+    (void) sig;
+    unlink(server.socket_path);
+    _exit(0);
+}
+
+static int fill_address(struct sockaddr_un* addr, const char* socket_path)
+{
+    if (strlen(socket_path) >= sizeof(addr->sun_path)) {
+        fprintf(stderr, "Socket path too long: \"%s\"\n", socket_path);
+        return -1;
+    }
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    strcpy(addr->sun_path, socket_path);
+    return 0;
+}
+
+int server_run(const char* socket_path, const char* conf_filename,
+        int version_major, int version_minor, int version_patch)
+{
+    struct sockaddr_un  addr;
+    int                 listen_fd;
+    int                 fd;
+
+    if (fill_address(&addr, socket_path) != 0)
+        return 1;
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("Failed to create the socket");
+        return 1;
+    }
+
+    if (bind(listen_fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+        _Bool           in_use = errno == EADDRINUSE;
+
+        /* replace the socket of a dead server, but not of a running one */
+        fd = in_use ? server_connect(socket_path) : -1;
+        if (!in_use || fd >= 0 || unlink(socket_path) != 0 ||
+                bind(listen_fd, (struct sockaddr*) &addr,
+                    sizeof(addr)) != 0) {
+            fprintf(stderr, "Failed to listen on \"%s\".\n", socket_path);
+            if (fd >= 0)
+                close(fd);
+            close(listen_fd);
+            return 1;
+        }
+    }
+    if (listen(listen_fd, SOMAXCONN) != 0) {
+        perror("Failed to listen on the socket");
+        close(listen_fd);
+        unlink(socket_path);
+        return 1;
+    }
+
+    server.socket_path = socket_path;
+    server.conf_filename = conf_filename ? conf_filename : ".editorconfig";
+    server.version_major = version_major;
+    server.version_minor = version_minor;
+    server.version_patch = version_patch;
+    server.watching = editorconfig_watch_start() == 0;
+    editorconfig_watch_set_callback(drop_results, NULL);
+#ifdef CMAKE_USE_PTHREADS_INIT
+    pthread_mutex_init(&server.mutex, NULL);
+#endif
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, stop_server);
+    signal(SIGTERM, stop_server);
+
+    for (;;) {
+        int*            arg;
+#ifdef CMAKE_USE_PTHREADS_INIT
+        pthread_t       thread;
+#endif
+
+        fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            perror("Failed to accept a connection");
+            break;
+        }
+
+        arg = (int*) malloc(sizeof(int));
+        if (!arg) {
+            close(fd);
+            continue;
+        }
+        *arg = fd;
+
+        /* each connection is served by its own thread if possible */
+#ifdef CMAKE_USE_PTHREADS_INIT
+        if (pthread_create(&thread, NULL, serve_connection, arg) == 0) {
+            pthread_detach(thread);
+            continue;
+        }
+#endif
+        serve_connection(arg);
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+    return 1;
+}
+
+int server_connect(const char* socket_path)
+{
+    struct sockaddr_un  addr;
+    int                 fd;
+
+    if (fill_address(&addr, socket_path) != 0)
+        return -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (connect(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0) {
+        int             err = errno;
+
+        close(fd);
+        errno = err;
+        return -1;
+    }
+
+    return fd;
+}
+
+void server_close(int fd)
+{
+    close(fd);
+}
+
+/* Write or read all the len bytes of data. Return -1 on failure or EOF. */
+static int write_all(int fd, const char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t         n = write(fd, data, len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        data += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+static int read_all(int fd, char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t         n = read(fd, data, len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        data += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+int server_send_message(int fd, const char* data, size_t len)
+{
+    unsigned char       header[4];
+
+    if (len > SERVER_MAX_MESSAGE_SIZE)
+        return -1;
+
+    header[0] = (unsigned char) (len >> 24);
+    header[1] = (unsigned char) (len >> 16);
+    header[2] = (unsigned char) (len >> 8);
+    header[3] = (unsigned char) len;
+
+    if (write_all(fd, (const char*) header, 4) != 0)
+        return -1;
+    return write_all(fd, data, len);
+}
+
+char* server_receive_message(int fd, size_t* len)
+{
+    unsigned char       header[4];
+    char*               data;
+
+    if (read_all(fd, (char*) header, 4) != 0)
+        return NULL;
+
+    *len = (size_t) header[0] << 24 | (size_t) header[1] << 16 |
+        (size_t) header[2] << 8 | header[3];
+    if (*len > SERVER_MAX_MESSAGE_SIZE)
+        return NULL;
+
+    /* one more byte, so that an empty message is not a NULL buffer */
+    data = (char*) malloc(*len + 1);
+    if (!data)
+        return NULL;
+    if (read_all(fd, data, *len) != 0) {
+        free(data);
+        return NULL;
+    }
+
+    return data;
+}
+
+#else /* HAVE_SYS_UN_H */
+
+int server_run(const char* socket_path, const char* conf_filename,
+        int version_major, int version_minor, int version_patch)
+{
+    (void) socket_path;
+    (void) conf_filename;
+    (void) version_major;
+    (void) version_minor;
+    (void) version_patch;
+
+    fprintf(stderr, "--serve is not supported on this platform.\n");
+    return 1;
+}
+
+int server_connect(const char* socket_path)
+{
+    (void) socket_path;
+    return -1;
+}
+
+void server_close(int fd)
+{
+    (void) fd;
+}
+
+int server_send_message(int fd, const char* data, size_t len)
+{
+    (void) fd;
+    (void) data;
+    (void) len;
+    return -1;
+}
+
+char* server_receive_message(int fd, size_t* len)
+{
+    (void) fd;
+    (void) len;
+    return NULL;
+}
+
+#endif /* HAVE_SYS_UN_H */
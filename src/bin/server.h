@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SERVER_H__
+#define __SERVER_H__
+
+/*
+ * The resolver daemon of "editorconfig --serve", and its protocol, which is
+ * used by "editorconfig --client" too.
+ *
+ * Clients connect to a Unix domain socket, and send requests and receive
+ * responses on the connection, in order. A message is a 32-bit big endian
+ * length followed by that many bytes:
+ *
+ * - A request is a sequence of NUL terminated full paths.
+ * - A response has a record per path of the request, in the same order. A
+ *   record is a sequence of NUL terminated fields: the path, the value
+ *   returned by editorconfig_parse() in decimal, then the name=value pairs if
+ *   it is 0 or the file of the error if it is positive, and an empty field.
+ */
+
+/* Max size of a message, bigger messages are protocol errors */
+#define SERVER_MAX_MESSAGE_SIZE     (64 << 20)
+
+/*
+ * Listen on socket_path and serve the requests until the process is killed.
+ * The files are resolved with the given conf file name, if not NULL, and
+ * version. Return 1 if the server cannot start.
+ */
+int server_run(const char* socket_path, const char* conf_filename,
+        int version_major, int version_minor, int version_patch);
+
+/* Connect to a server. Return the socket, or -1 on failure. */
+int server_connect(const char* socket_path);
+
+/* Close a connection to a server */
+void server_close(int fd);
+
+/* Send a message. Return 0 on success, -1 on failure. */
+int server_send_message(int fd, const char* data, size_t len);
+
+/*
+ * Receive a message into a newly allocated buffer, storing its length in len.
+ * Return NULL at the end of the connection or on failure.
+ */
+char* server_receive_message(int fd, size_t* len);
+
+#endif /* !__SERVER_H__ */
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "global.h"
+
+#include "ec_arena.h"
+
+/* Size of the first block of an arena */
+#ifndef EC_ARENA_BLOCK_SIZE
+# define EC_ARENA_BLOCK_SIZE        4096
+#endif
+
+/* the strictest alignment of the basic types */
+typedef union
+{
+    long                    l;
+    double                  d;
+    void*                   p;
+} ec_arena_align;
+
+#define ALIGN_UP(size) \
+    (((size) + sizeof(ec_arena_align) - 1) & ~(sizeof(ec_arena_align) - 1))
+
+struct ec_arena_block
+{
+    ec_arena_block*         next;
+    /* bytes available after the header */
+    size_t                  size;
+};
+
+#define BLOCK_HEADER_SIZE   ALIGN_UP(sizeof(ec_arena_block))
+#define BLOCK_DATA(block)   ((char*)(block) + BLOCK_HEADER_SIZE)
+
+/*
+ * Add a block of at least size bytes in front of the blocks of arena. Return
+ * -1 if memory runs out.
+ */
+static int ec_arena_add_block(ec_arena* arena, size_t size)
+{
+    ec_arena_block*     block;
+    size_t              block_size = EC_ARENA_BLOCK_SIZE;
+
+    if (arena->blocks && block_size < 2 * arena->blocks->size)
+        block_size = 2 * arena->blocks->size;
+    if (block_size < size)
+        block_size = size;
+
+    block = (ec_arena_block*)malloc(BLOCK_HEADER_SIZE + block_size);
+    if (!block)
+        return -1;
+    block->next = arena->blocks;
+    block->size = block_size;
+    arena->blocks = block;
+    arena->used = 0;
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void* ec_arena_alloc(ec_arena* arena, size_t size)
+{
+    void*               ptr;
+
+    size = ALIGN_UP(size);
+    if ((!arena->blocks || arena->blocks->size - arena->used < size) &&
+            ec_arena_add_block(arena, size) != 0)
+        return NULL;
+
+    ptr = BLOCK_DATA(arena->blocks) + arena->used;
+    arena->used += size;
+    arena->total += size;
+    arena->last = ptr;
+
+    return ptr;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void* ec_arena_grow(ec_arena* arena, void* ptr, size_t old_size,
+        size_t new_size)
+{
+    void*               new_ptr;
+
+    if (ptr && ptr == arena->last) {
+        size_t          start = (size_t)((char*)ptr -
+                BLOCK_DATA(arena->blocks));
+
+        if (start + ALIGN_UP(new_size) <= arena->blocks->size) {
+            arena->total += ALIGN_UP(new_size) - (arena->used - start);
+            arena->used = start + ALIGN_UP(new_size);
+            return ptr;
+        }
+    }
+
+    new_ptr = ec_arena_alloc(arena, new_size);
+    if (new_ptr && ptr)
+        memcpy(new_ptr, ptr, old_size);
+
+    return new_ptr;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+char* ec_arena_strdup(ec_arena* arena, const char* str)
+{
+    return ec_arena_strndup(arena, str, strlen(str));
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+char* ec_arena_strndup(ec_arena* arena, const char* str, size_t n)
+{
+    char*               copy;
+    const char*         end = (const char*)memchr(str, '\0', n);
+
+    if (end)
+        n = (size_t)(end - str);
+
+    copy = (char*)ec_arena_alloc(arena, n + 1);
+    if (!copy)
+        return NULL;
+    memcpy(copy, str, n);
+    copy[n] = '\0';
+
+    return copy;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_arena_reset(ec_arena* arena)
+{
+    size_t              capacity = 0;
+    ec_arena_block*     block;
+
+    if (arena->blocks && arena->blocks->next) {
+        /* merge the blocks into one as large as all of them */
+        for (block = arena->blocks; block; block = block->next)
+            capacity += block->size;
+        ec_arena_free(arena);
+        ec_arena_add_block(arena, capacity);
+    }
+
+    arena->used = 0;
+    arena->total = 0;
+    arena->last = NULL;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_arena_free(ec_arena* arena)
+{
+    while (arena->blocks) {
+        ec_arena_block*     next = arena->blocks->next;
+
+        free(arena->blocks);
+        arena->blocks = next;
+    }
+
+    memset(arena, 0, sizeof(ec_arena));
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EC_ARENA_H__
+#define __EC_ARENA_H__
+
+#include "global.h"
+
+typedef struct ec_arena_block ec_arena_block;
+
+/*
+ * A bump allocator. The memory allocated from an arena is released all at
+ * once by ec_arena_reset() or ec_arena_free(). An arena is initialized by
+ * filling it with zeros.
+ */
+typedef struct
+{
+    /* the current block first */
+    ec_arena_block*         blocks;
+    /* bytes used in the current block */
+    size_t                  used;
+    /* bytes allocated since the last reset */
+    size_t                  total;
+    /* the last allocation, which is grown in place if possible */
+    void*                   last;
+} ec_arena;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Allocate size bytes from arena, aligned for any type. Return NULL if memory
+ * runs out.
+ */
+EDITORCONFIG_LOCAL
+void* ec_arena_alloc(ec_arena* arena, size_t size);
+
+/*
+ * Grow ptr, allocated from arena with old_size bytes, to new_size bytes. ptr
+ * is grown in place if it is the last allocation and the block has room for
+ * it, and copied otherwise. Return NULL if memory runs out.
+ */
+EDITORCONFIG_LOCAL
+void* ec_arena_grow(ec_arena* arena, void* ptr, size_t old_size,
+        size_t new_size);
+
+EDITORCONFIG_LOCAL
+char* ec_arena_strdup(ec_arena* arena, const char* str);
+
+EDITORCONFIG_LOCAL
+char* ec_arena_strndup(ec_arena* arena, const char* str, size_t n);
+
+/*
+ * Release all the memory allocated from arena, but keep it for the next
+ * allocations. If the last use took several blocks, they are merged into a
+ * single one as large as all of them, so that the memory of arena only grows
+ * and the same use does not allocate any more.
+ */
+EDITORCONFIG_LOCAL
+void ec_arena_reset(ec_arena* arena);
+
+/* Release all the memory of arena to the system */
+EDITORCONFIG_LOCAL
+void ec_arena_free(ec_arena* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !__EC_ARENA_H__ */
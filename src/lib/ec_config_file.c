@@ -0,0 +1,791 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "global.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "misc.h"
+#include "ini.h"
+#include "ec_mutex.h"
+
+#include "ec_config_file.h"
+
+/* Max count of files kept in the config file cache */
+#ifndef EC_CONFIG_CACHE_SIZE
+# define EC_CONFIG_CACHE_SIZE       4096
+#endif
+#define EC_CONFIG_CACHE_BUCKETS     (2 * EC_CONFIG_CACHE_SIZE)
+
+/*
+ * Process-wide cache of parsed EditorConfig files keyed by their full path.
+ * Files that do not exist are cached as well, since most directories do not
+ * contain any EditorConfig file. The LRU list is ordered from the most
+ * recently used entry (lru_head) to the least recently used one (lru_tail).
+ */
+static struct
+{
+    ec_config_file*         buckets[EC_CONFIG_CACHE_BUCKETS];
+    ec_config_file*         lru_head;
+    ec_config_file*         lru_tail;
+    int                     count;
+    /* count of existing files read from disk or found deleted so far */
+    unsigned long           change_count;
+} config_cache;
+static ec_mutex config_cache_mutex = EC_MUTEX_INITIALIZER;
+
+/* the first parameter passed to collect_handler() */
+typedef struct
+{
+    ec_config_file*         cf;
+    /* allocated count of sections and of properties of the last section */
+    int                     section_capacity;
+    int                     property_capacity;
+} collect_param;
+
+static void stamp_from_stat(ec_file_stamp* stamp, const struct stat* sb)
+{
+    stamp->exists = 1;
+    stamp->dev = (unsigned long)sb->st_dev;
+    stamp->ino = (unsigned long)sb->st_ino;
+    stamp->size = (long)sb->st_size;
+    stamp->mtime = (long)sb->st_mtime;
+    stamp->ctime = (long)sb->st_ctime;
+    /* sub-second timestamps, so that a rewrite within the same second is
+     * noticed */
+#if defined(HAVE_STRUCT_STAT_ST_MTIM)
+    stamp->mtime_nsec = (long)sb->st_mtim.tv_nsec;
+    stamp->ctime_nsec = (long)sb->st_ctim.tv_nsec;
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC)
+    stamp->mtime_nsec = (long)sb->st_mtimespec.tv_nsec;
+    stamp->ctime_nsec = (long)sb->st_ctimespec.tv_nsec;
+#endif
+}
+
+static void stamp_of_path(ec_file_stamp* stamp, const char* path)
+{
+    struct stat         sb;
+
+    memset(stamp, 0, sizeof(ec_file_stamp));
+    if (stat(path, &sb) == 0)
+        stamp_from_stat(stamp, &sb);
+}
+
+static _Bool stamp_equal(const ec_file_stamp* s1, const ec_file_stamp* s2)
+{
+    if (!s1->exists || !s2->exists)
+        return s1->exists == s2->exists;
+
+    return s1->dev == s2->dev && s1->ino == s2->ino &&
+        s1->size == s2->size &&
+        s1->mtime == s2->mtime && s1->mtime_nsec == s2->mtime_nsec &&
+        s1->ctime == s2->ctime && s1->ctime_nsec == s2->ctime_nsec;
+}
+
+/*
+ * Store the INI name=value pairs into the ec_config_file in the order they
+ * appear in the file.
+ */
+static int collect_handler(void* cparam, const ini_slice* section,
+        const ini_slice* name, const ini_slice* value)
+{
+    collect_param*      cp = (collect_param*)cparam;
+    ec_config_file*     cf = cp->cf;
+    ec_section*         sec;
+    ec_property*        prop;
+
+    /* start a new section when the section name changes */
+    if (cf->section_count == 0 ||
+            strlen(cf->sections[cf->section_count - 1].name) != section->len ||
+            memcmp(cf->sections[cf->section_count - 1].name, section->str,
+                section->len)) {
+        if (cf->section_count >= cp->section_capacity) {
+            int             new_capacity = cp->section_capacity ?
+                2 * cp->section_capacity : 8;
+            ec_section*     new_sections = (ec_section*)realloc(
+                    cf->sections, sizeof(ec_section) * new_capacity);
+
+            if (!new_sections)
+                return 0;
+            cf->sections = new_sections;
+            cp->section_capacity = new_capacity;
+        }
+
+        sec = &cf->sections[cf->section_count];
+        memset(sec, 0, sizeof(ec_section));
+        sec->name = strndup(section->str, section->len);
+        if (!sec->name)
+            return 0;
+        ++ cf->section_count;
+        cp->property_capacity = 0;
+    }
+
+    sec = &cf->sections[cf->section_count - 1];
+    if (sec->property_count >= cp->property_capacity) {
+        int             new_capacity = cp->property_capacity ?
+            2 * cp->property_capacity : 8;
+        ec_property*    new_properties = (ec_property*)realloc(
+                sec->properties, sizeof(ec_property) * new_capacity);
+
+        if (!new_properties)
+            return 0;
+        sec->properties = new_properties;
+        cp->property_capacity = new_capacity;
+    }
+
+    prop = &sec->properties[sec->property_count];
+    prop->name = strndup(name->str, name->len);
+    prop->value = strndup(value->str, value->len);
+    if (!prop->name || !prop->value) {
+        free(prop->name);
+        free(prop->value);
+        return 0;
+    }
+    ++ sec->property_count;
+
+    return 1;
+}
+
+/*
+ * Build the glob pattern of a section of the EditorConfig file located in
+ * editorconfig_file_dir. Return NULL if memory runs out.
+ */
+static char* get_section_pattern(const char* editorconfig_file_dir,
+        const char* section)
+{
+    char*                pattern;
+
+    /* pattern would be: /dir/of/editorconfig/file[double_star]/[section] if
+     * section does not contain '/', or /dir/of/editorconfig/file[section]
+     * if section starts with a '/', or /dir/of/editorconfig/file/[section] if
+     * section contains '/' but does not start with '/' */
+    pattern = (char*)malloc(
+            strlen(editorconfig_file_dir) * sizeof(char) +
+            sizeof("**/") + strlen(section) * sizeof(char));
+    if (!pattern)
+        return NULL;
+    strcpy(pattern, editorconfig_file_dir);
+
+    if (strchr(section, '/') == NULL) /* No / is found, append '[star][star]/' */
+        strcat(pattern, "**/");
+    else if (*section != '/') /* The first char is not '/' but section contains
+                                 '/', append a '/' */
+        strcat(pattern, "/");
+
+    strcat(pattern, section);
+
+    return pattern;
+}
+
+/* Max count of literals a section is expanded to by its braces */
+#define NAME_LITERAL_MAX    64
+
+/*
+ * Expand the braces of the end of a section name, from text to end, into
+ * literals, each allocated with room for prefix_len more characters at its
+ * start. Only braces of literal alternatives, such as {c,h}, are expanded.
+ * Return the count of literals, or -1 if text is not such a literal or memory
+ * runs out.
+ */
+static int expand_name_literals(const char* text, const char* end,
+        char** literals)
+{
+    char*           expanded[NAME_LITERAL_MAX];
+    const char*     alternatives[NAME_LITERAL_MAX];
+    size_t          lens[NAME_LITERAL_MAX];
+    int             count = 1;
+    int             alt_count;
+    int             i;
+    int             j;
+    const char*     c;
+
+    literals[0] = strdup("");
+    if (!literals[0])
+        return -1;
+
+    for (c = text; c < end; ++c) {
+        /* one or more literal characters, appended to all the literals */
+        if (*c != '{') {
+            char        ch = *c;
+
+            if (ch == '\\' && c + 1 < end)
+                ch = *++c;
+            else if (strchr("*?[]{},\\", ch))
+                goto opaque;
+
+            for (i = 0; i < count; ++i) {
+                size_t      len = strlen(literals[i]);
+                char*       grown = (char*)realloc(literals[i], len + 2);
+
+                if (!grown)
+                    goto opaque;
+                literals[i] = grown;
+                grown[len] = ch;
+                grown[len + 1] = '\0';
+            }
+            continue;
+        }
+
+        /* {a,b,c}: the alternatives are literals, without any escape */
+        alt_count = 0;
+        alternatives[alt_count] = ++c;
+        for (; c < end && *c != '}'; ++c) {
+            if (strchr("*?[]{\\", *c))
+                goto opaque;
+            if (*c == ',') {
+                lens[alt_count] = (size_t)(c - alternatives[alt_count]);
+                if (++alt_count == NAME_LITERAL_MAX)
+                    goto opaque;
+                alternatives[alt_count] = c + 1;
+            }
+        }
+        /* {single} is a literal or a range of numbers, not an alternative */
+        if (c == end || alt_count == 0 ||
+                (alt_count + 1) * count > NAME_LITERAL_MAX)
+            goto opaque;
+        lens[alt_count] = (size_t)(c - alternatives[alt_count]);
+        ++ alt_count;
+
+        for (i = 0; i < count; ++i) {
+            for (j = 0; j < alt_count; ++j) {
+                size_t      len = strlen(literals[i]);
+
+                expanded[i * alt_count + j] = (char*)malloc(
+                        len + lens[j] + 1);
+                if (!expanded[i * alt_count + j]) {
+                    while (--j >= 0)
+                        free(expanded[i * alt_count + j]);
+                    while (--i >= 0)
+                        for (j = 0; j < alt_count; ++j)
+                            free(expanded[i * alt_count + j]);
+                    goto opaque;
+                }
+                memcpy(expanded[i * alt_count + j], literals[i], len);
+                memcpy(expanded[i * alt_count + j] + len, alternatives[j],
+                        lens[j]);
+                expanded[i * alt_count + j][len + lens[j]] = '\0';
+            }
+        }
+        for (i = 0; i < count; ++i)
+            free(literals[i]);
+        count *= alt_count;
+        for (i = 0; i < count; ++i)
+            literals[i] = expanded[i];
+    }
+
+    return count;
+
+opaque:
+    for (i = 0; i < count; ++i)
+        free(literals[i]);
+    return -1;
+}
+
+/*
+ * Add the tests made by section on the names of the files to cf. Return 0
+ * on success, 1 if the section looks at the names otherwise, -1 if memory
+ * runs out.
+ */
+static int add_section_name_tests(ec_config_file* cf, const char* section)
+{
+    char*           literals[NAME_LITERAL_MAX];
+    const char*     name = section;
+    const char*     c;
+    _Bool           is_suffix = 0;
+    int             count;
+    int             depth = 0;
+    int             i;
+    int             j;
+
+    /* the name of a file is matched by the part of the section after its
+     * last slash outside of braces, the part before it only depends on the
+     * directory of the file */
+    for (c = section; *c; ++c) {
+        if (*c == '\\' && c[1])
+            ++c;
+        else if (*c == '{')
+            ++ depth;
+        else if (*c == '}')
+            -- depth;
+        else if (*c == '/' && depth == 0)
+            name = c + 1;
+        else if (*c == '/')
+            return 1;
+    }
+    /* unpaired braces are matched literally */
+    if (depth != 0)
+        return 1;
+
+    /* * and ** both match any start of the name, as long as the rest does
+     * not look at the name otherwise */
+    if (name[0] == '*') {
+        is_suffix = 1;
+        name += name[1] == '*' ? 2 : 1;
+    }
+
+    count = expand_name_literals(name, name + strlen(name), literals);
+    if (count < 0)
+        return 1;
+
+    for (i = 0; i < count; ++i) {
+        for (j = 0; j < cf->name_test_count; ++j)
+            if (cf->name_tests[j].is_suffix == is_suffix &&
+                    !strcmp(cf->name_tests[j].literal, literals[i]))
+                break;
+        if (j < cf->name_test_count) {
+            free(literals[i]);
+            continue;
+        }
+
+        if ((cf->name_test_count & (cf->name_test_count - 1)) == 0) {
+            ec_name_test*   grown = (ec_name_test*)realloc(cf->name_tests,
+                    (cf->name_test_count ? 2 * cf->name_test_count : 1) *
+                    sizeof(ec_name_test));
+
+            if (!grown) {
+                for (; i < count; ++i)
+                    free(literals[i]);
+                return -1;
+            }
+            cf->name_tests = grown;
+        }
+        cf->name_tests[cf->name_test_count].literal = literals[i];
+        cf->name_tests[cf->name_test_count].len = strlen(literals[i]);
+        cf->name_tests[cf->name_test_count].is_suffix = is_suffix;
+        ++ cf->name_test_count;
+    }
+
+    return 0;
+}
+
+/*
+ * Collect the tests made by the sections of cf on the names of the files.
+ * Return -1 if memory runs out.
+ */
+static int ec_config_file_classify(ec_config_file* cf)
+{
+    int             i;
+    int             ret;
+
+    /* braces or wildcards in the directory change how the sections are
+     * matched, see ec_glob() */
+    if (strpbrk(cf->dir, "*?[]{}\\")) {
+        cf->names_opaque = 1;
+        return 0;
+    }
+
+    for (i = 0; i < cf->section_count; ++i) {
+        ret = add_section_name_tests(cf, cf->sections[i].name);
+        if (ret < 0)
+            return -1;
+        if (ret > 0) {
+            cf->names_opaque = 1;
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Compile the globs of all the sections of cf, and prepare the property
+ * names to be looked up. Return -1 if memory runs out.
+ */
+static int ec_config_file_compile(ec_config_file* cf)
+{
+    char**          patterns;
+    int             i;
+    int             j;
+    int             err_num = 0;
+
+    /* property names are case insensitive, lower them once for all the
+     * files this file applies to */
+    for (i = 0; i < cf->section_count; ++i) {
+        for (j = 0; j < cf->sections[i].property_count; ++j) {
+            ec_property*    prop = &cf->sections[i].properties[j];
+
+            strlwr(prop->name);
+            prop->name_hash = ec_str_hash(prop->name);
+        }
+    }
+
+    patterns = (char**)calloc(cf->section_count + 1, sizeof(char*));
+    if (!patterns)
+        return -1;
+
+    for (i = 0; i < cf->section_count; ++i) {
+        patterns[i] = get_section_pattern(cf->dir, cf->sections[i].name);
+        if (!patterns[i])
+            err_num = -1;
+    }
+
+    if (err_num == 0) {
+        cf->matcher = ec_glob_set_new((const char* const*)patterns,
+                cf->section_count);
+        if (!cf->matcher)
+            err_num = -1;
+    }
+
+    if (err_num == 0)
+        err_num = ec_config_file_classify(cf);
+
+    for (i = 0; i < cf->section_count; ++i)
+        free(patterns[i]);
+    free(patterns);
+
+    return err_num;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_config_file_free(ec_config_file* cf)
+{
+    int             i;
+    int             j;
+
+    for (i = 0; i < cf->section_count; ++i) {
+        for (j = 0; j < cf->sections[i].property_count; ++j) {
+            free(cf->sections[i].properties[j].name);
+            free(cf->sections[i].properties[j].value);
+        }
+        free(cf->sections[i].properties);
+        free(cf->sections[i].name);
+    }
+    free(cf->sections);
+    ec_glob_set_free(cf->matcher);
+    for (i = 0; i < cf->name_test_count; ++i)
+        free(cf->name_tests[i].literal);
+    free(cf->name_tests);
+    free(cf->path);
+    free(cf->dir);
+    free(cf);
+}
+
+/*
+ * Create an empty ec_config_file for path. Return NULL if memory runs out.
+ */
+static ec_config_file* ec_config_file_new(const char* path, unsigned int hash)
+{
+    ec_config_file*     cf;
+    const char*         slash;
+
+    cf = (ec_config_file*)calloc(1, sizeof(ec_config_file));
+    if (!cf)
+        return NULL;
+
+    cf->path = strdup(path);
+    slash = strrchr(path, '/');
+    cf->dir = strndup(path, slash ? (size_t)(slash - path) : 0);
+    if (!cf->path || !cf->dir) {
+        ec_config_file_free(cf);
+        return NULL;
+    }
+    cf->hash = hash;
+    cf->ref_count = 1;
+
+    return cf;
+}
+
+/*
+ * Read and parse the file at path. Return NULL if memory runs out.
+ */
+static ec_config_file* ec_config_file_load(const char* path,
+        unsigned int hash)
+{
+    ec_config_file*     cf;
+    collect_param       cp;
+    FILE*               file;
+    struct stat         sb;
+
+    cf = ec_config_file_new(path, hash);
+    if (!cf)
+        return NULL;
+
+    file = fopen(path, "r");
+    if (!file) {
+        /* a file we are not able to open is regarded as absent, but is
+         * stamped as found on disk so that it is not reopened every time */
+        stamp_of_path(&cf->stamp, path);
+        return cf;
+    }
+
+    /* stamp the file we are actually reading */
+    if (fstat(fileno(file), &sb) == 0)
+        stamp_from_stat(&cf->stamp, &sb);
+    else
+        stamp_of_path(&cf->stamp, path);
+
+    memset(&cp, 0, sizeof(cp));
+    cp.cf = cf;
+    cf->parse_error = ini_parse_stream(file, collect_handler, &cp);
+    fclose(file);
+
+    if (cf->parse_error == -2) {    /* not read into memory */
+        ec_config_file_free(cf);
+        return NULL;
+    }
+
+    /* a file with a parsing error is never applied, no need to compile it */
+    if (cf->parse_error == 0 && cf->section_count > 0 &&
+            ec_config_file_compile(cf) != 0) {
+        ec_config_file_free(cf);
+        return NULL;
+    }
+
+    return cf;
+}
+
+/* Drop one reference of cf. config_cache_mutex must be held. */
+static void ec_config_file_unref(ec_config_file* cf)
+{
+    if (-- cf->ref_count == 0)
+        ec_config_file_free(cf);
+}
+
+/* Unlink cf from the LRU list. config_cache_mutex must be held. */
+static void config_cache_lru_unlink(ec_config_file* cf)
+{
+    if (cf->lru_prev)
+        cf->lru_prev->lru_next = cf->lru_next;
+    else
+        config_cache.lru_head = cf->lru_next;
+
+    if (cf->lru_next)
+        cf->lru_next->lru_prev = cf->lru_prev;
+    else
+        config_cache.lru_tail = cf->lru_prev;
+
+    cf->lru_prev = cf->lru_next = NULL;
+}
+
+/* Make cf the most recently used entry. config_cache_mutex must be held. */
+static void config_cache_lru_push_front(ec_config_file* cf)
+{
+    cf->lru_prev = NULL;
+    cf->lru_next = config_cache.lru_head;
+    if (config_cache.lru_head)
+        config_cache.lru_head->lru_prev = cf;
+    config_cache.lru_head = cf;
+    if (!config_cache.lru_tail)
+        config_cache.lru_tail = cf;
+}
+
+/* Remove cf from the cache. config_cache_mutex must be held. */
+static void config_cache_remove(ec_config_file* cf)
+{
+    ec_config_file**    pp;
+
+    for (pp = &config_cache.buckets[cf->hash % EC_CONFIG_CACHE_BUCKETS]; *pp;
+            pp = &(*pp)->hash_next) {
+        if (*pp == cf) {
+            *pp = cf->hash_next;
+            break;
+        }
+    }
+
+    config_cache_lru_unlink(cf);
+    -- config_cache.count;
+    ec_config_file_unref(cf);
+}
+
+/* Look up path in the cache. config_cache_mutex must be held. */
+static ec_config_file* config_cache_find(const char* path, unsigned int hash)
+{
+    ec_config_file*     cf;
+
+    for (cf = config_cache.buckets[hash % EC_CONFIG_CACHE_BUCKETS]; cf;
+            cf = cf->hash_next)
+        if (cf->hash == hash && !strcmp(cf->path, path))
+            return cf;
+
+    return NULL;
+}
+
+/*
+ * Add cf to the cache, evicting the least recently used entry if the cache is
+ * full. config_cache_mutex must be held.
+ */
+static void config_cache_insert(ec_config_file* cf)
+{
+    if (config_cache.count >= EC_CONFIG_CACHE_SIZE)
+        config_cache_remove(config_cache.lru_tail);
+
+    cf->hash_next = config_cache.buckets[cf->hash % EC_CONFIG_CACHE_BUCKETS];
+    config_cache.buckets[cf->hash % EC_CONFIG_CACHE_BUCKETS] = cf;
+    config_cache_lru_push_front(cf);
+    ++ cf->ref_count;       /* the reference held by the cache */
+    ++ config_cache.count;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+ec_config_file* ec_config_file_acquire(const char* path)
+{
+    unsigned int        hash = ec_str_hash(path);
+    ec_file_stamp       stamp;
+    ec_config_file*     cf;
+    ec_config_file*     old_cf;
+
+    stamp_of_path(&stamp, path);
+
+    ec_mutex_lock(&config_cache_mutex);
+    cf = config_cache_find(path, hash);
+    if (cf && stamp_equal(&cf->stamp, &stamp)) {
+        config_cache_lru_unlink(cf);
+        config_cache_lru_push_front(cf);
+        ++ cf->ref_count;
+        ec_mutex_unlock(&config_cache_mutex);
+        return cf;
+    }
+    ec_mutex_unlock(&config_cache_mutex);
+
+    /* not cached or out of date, read it without holding the lock */
+    if (stamp.exists)
+        cf = ec_config_file_load(path, hash);
+    else
+        cf = ec_config_file_new(path, hash);
+    if (!cf)
+        return NULL;
+
+    ec_mutex_lock(&config_cache_mutex);
+    old_cf = config_cache_find(path, hash);
+    if (cf->stamp.exists || (old_cf && old_cf->stamp.exists))
+        ++ config_cache.change_count;
+    if (old_cf)
+        config_cache_remove(old_cf);
+    config_cache_insert(cf);
+    ec_mutex_unlock(&config_cache_mutex);
+
+    return cf;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_config_file_release(ec_config_file* cf)
+{
+    ec_mutex_lock(&config_cache_mutex);
+    ec_config_file_unref(cf);
+    ec_mutex_unlock(&config_cache_mutex);
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_config_file_retain(ec_config_file* cf)
+{
+    ec_mutex_lock(&config_cache_mutex);
+    ++ cf->ref_count;
+    ec_mutex_unlock(&config_cache_mutex);
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+int ec_config_file_match(const ec_config_file* cf, const char* full_filename,
+        const unsigned char* wanted, unsigned char* matched)
+{
+    if (cf->section_count == 0)
+        return 0;
+
+    return ec_glob_set_match(cf->matcher, full_filename, wanted, matched);
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+ec_config_file* ec_config_file_create(const char* path)
+{
+    return ec_config_file_new(path, ec_str_hash(path));
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+int ec_config_file_add(ec_config_file* cf)
+{
+    if (cf->parse_error == 0 && cf->section_count > 0 &&
+            ec_config_file_compile(cf) != 0) {
+        ec_config_file_free(cf);
+        return -1;
+    }
+
+    ec_mutex_lock(&config_cache_mutex);
+    if (config_cache_find(cf->path, cf->hash)) {
+        ec_mutex_unlock(&config_cache_mutex);
+        ec_config_file_free(cf);
+        return 0;
+    }
+    config_cache_insert(cf);
+    -- cf->ref_count;       /* only the cache holds it */
+    ec_mutex_unlock(&config_cache_mutex);
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+int ec_config_file_foreach(int (*fn)(const ec_config_file* cf, void* user),
+        void* user)
+{
+    ec_config_file*     cf;
+    int                 ret = 0;
+
+    ec_mutex_lock(&config_cache_mutex);
+    for (cf = config_cache.lru_tail; cf && ret == 0; cf = cf->lru_prev)
+        if (cf->stamp.exists)
+            ret = fn(cf, user);
+    ec_mutex_unlock(&config_cache_mutex);
+
+    return ret;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+unsigned long ec_config_file_change_count(void)
+{
+    unsigned long       change_count;
+
+    ec_mutex_lock(&config_cache_mutex);
+    change_count = config_cache.change_count;
+    ec_mutex_unlock(&config_cache_mutex);
+
+    return change_count;
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EC_CONFIG_FILE_H__
+#define __EC_CONFIG_FILE_H__
+
+#include "global.h"
+#include "ec_glob.h"
+
+/*
+ * A name=value pair as it appears in an EditorConfig file. Once the file is
+ * compiled, the name is lowercase and name_hash is its ec_str_hash().
+ */
+typedef struct ec_property
+{
+    char*                   name;
+    char*                   value;
+    unsigned int            name_hash;
+} ec_property;
+
+/* A section of an EditorConfig file. The preamble is the section named "". */
+typedef struct ec_section
+{
+    char*                   name;
+    ec_property*            properties;
+    int                     property_count;
+} ec_section;
+
+/* The fingerprint used to detect whether a file has changed on disk */
+typedef struct ec_file_stamp
+{
+    _Bool                   exists;
+    unsigned long           dev;
+    unsigned long           ino;
+    long                    size;
+    long                    mtime;
+    long                    mtime_nsec;
+    long                    ctime;
+    long                    ctime_nsec;
+} ec_file_stamp;
+
+/*
+ * A test made by the sections of an EditorConfig file on the name of a file,
+ * the last component of its path: whether the name ends with literal, or is
+ * literal. Sections such as [*.c], [**.{js,ts}] or [Makefile] only look at the
+ * name of a file through such tests, besides its directory.
+ */
+typedef struct ec_name_test
+{
+    char*                   literal;
+    size_t                  len;
+    _Bool                   is_suffix;
+} ec_name_test;
+
+/*
+ * A parsed EditorConfig file. A file which does not exist is represented as
+ * an ec_config_file whose stamp.exists is 0 and which has no section.
+ */
+typedef struct ec_config_file
+{
+    /* full path of the file */
+    char*                   path;
+    /* directory of the file, without the trailing slash */
+    char*                   dir;
+    ec_file_stamp           stamp;
+    /* line number of the first parsing error, or 0 */
+    int                     parse_error;
+    ec_section*             sections;
+    int                     section_count;
+    /* the globs of all the sections, matched in a single pass */
+    ec_glob_set*            matcher;
+    /* the tests of the sections on the names of the files, unless
+     * names_opaque is set because a section looks at the names otherwise.
+     * Two files in the same directory with the same results for all the tests
+     * are matched by the same sections. */
+    ec_name_test*           name_tests;
+    int                     name_test_count;
+    _Bool                   names_opaque;
+
+    /* cache bookkeeping, see ec_config_file.c */
+    unsigned int            hash;
+    int                     ref_count;
+    struct ec_config_file*  hash_next;
+    struct ec_config_file*  lru_prev;
+    struct ec_config_file*  lru_next;
+} ec_config_file;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Get the parsed content of the EditorConfig file at path. The file is read
+ * from disk only if it is not in the cache yet or has changed since it was
+ * cached. Return NULL if memory runs out. The returned object must be
+ * released with ec_config_file_release().
+ */
+EDITORCONFIG_LOCAL
+ec_config_file* ec_config_file_acquire(const char* path);
+
+EDITORCONFIG_LOCAL
+void ec_config_file_release(ec_config_file* cf);
+
+/* Take one more reference on cf, acquired already */
+EDITORCONFIG_LOCAL
+void ec_config_file_retain(ec_config_file* cf);
+
+/*
+ * Set matched[i] to 1 if the ith section of cf matches full_filename, and to
+ * 0 otherwise. If wanted is not NULL, only the ith sections whose wanted[i]
+ * is not 0 are matched. Return 0 on success, -1 if memory runs out.
+ */
+EDITORCONFIG_LOCAL
+int ec_config_file_match(const ec_config_file* cf, const char* full_filename,
+        const unsigned char* wanted, unsigned char* matched);
+
+/*
+ * Create an ec_config_file for path which is not in the cache, with no
+ * section and an empty stamp. Return NULL if memory runs out.
+ */
+EDITORCONFIG_LOCAL
+ec_config_file* ec_config_file_create(const char* path);
+
+/* Free an ec_config_file which is not in the cache. */
+EDITORCONFIG_LOCAL
+void ec_config_file_free(ec_config_file* cf);
+
+/*
+ * Compile the sections of cf, created by ec_config_file_create() and filled
+ * by the caller, and add it to the cache. cf is freed instead if the cache
+ * has the file already. Like any cached file, cf is checked against its
+ * stamp when it is acquired. Return 0 on success, -1 if memory runs out.
+ */
+EDITORCONFIG_LOCAL
+int ec_config_file_add(ec_config_file* cf);
+
+/*
+ * Call fn for each cached file that exists, from the least recently used
+ * one. The cache is locked meanwhile. Stop at the first nonzero value
+ * returned by fn and return it, or return 0.
+ */
+EDITORCONFIG_LOCAL
+int ec_config_file_foreach(int (*fn)(const ec_config_file* cf, void* user),
+        void* user);
+
+/*
+ * The count of existing files read from disk, or found deleted, by
+ * ec_config_file_acquire() so far. The count is unchanged as long as the
+ * existing files of the cache are those found on disk.
+ */
+EDITORCONFIG_LOCAL
+unsigned long ec_config_file_change_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !__EC_CONFIG_FILE_H__ */
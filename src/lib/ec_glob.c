@@ -26,342 +26,232 @@
 
 #include "global.h"
 
-#include <ctype.h>
 #include <string.h>
-#include <pcre.h>
 
-#include "utarray.h"
 #include "misc.h"
+#include "ec_mutex.h"
 
 #include "ec_glob.h"
 
-typedef struct int_pair
-{
-    int     num1;
-    int     num2;
-} int_pair;
-static const UT_icd ut_int_pair_icd = {sizeof(int_pair),NULL,NULL,NULL};
-
-/* concatenate the string then move the pointer to the end */
-#define STRING_CAT(p, string, end)  do {    \
-    size_t string_len = strlen(string); \
-    if (p + string_len >= end) \
-        return -1; \
-    strcat(p, string); \
-    p += string_len; \
-} while(0)
-
-#define PATTERN_MAX  300
 /*
- * Whether the string matches the given glob pattern
+ * A compiled glob pattern, shared through the glob cache below. Compiled
+ * patterns are reference counted, so that an entry evicted from the cache
+ * stays alive while another thread is still matching against it.
  */
-EDITORCONFIG_LOCAL
-int ec_glob(const char *pattern, const char *string)
+typedef struct ec_glob_re
 {
-    size_t                    i;
-    int_pair *                p;
-    char *                    c;
-    char                      pcre_str[2 * PATTERN_MAX] = "^";
-    char *                    p_pcre;
-    char *                    pcre_str_end;
-    int                       brace_level = 0;
-    _Bool                     is_in_bracket = 0;
-    const char *              error_msg;
-    int                       erroffset;
-    pcre *                    re;
-    int                       rc;
-    int *                     pcre_result;
-    size_t                    pcre_result_len;
-    char                      l_pattern[2 * PATTERN_MAX];
-    int                       pattern_length = strlen(pattern);
-    _Bool                     are_brace_paired;
-    UT_array *                nums;     /* number ranges */
-    int                       ret = 0;
-
-    strcpy(l_pattern, pattern);
-    p_pcre = pcre_str + 1;
-    pcre_str_end = pcre_str + 2 * PATTERN_MAX;
+    char*                   pattern;
+    unsigned int            hash;
+    ec_glob_set*            set;        /* a set of this single pattern */
+    int                     ref_count;
+    struct ec_glob_re*      hash_next;
+    struct ec_glob_re*      lru_prev;
+    struct ec_glob_re*      lru_next;
+} ec_glob_re;
+
+/* Max count of compiled patterns kept in the glob cache */
+#ifndef EC_GLOB_CACHE_SIZE
+# define EC_GLOB_CACHE_SIZE     256
+#endif
+#define EC_GLOB_CACHE_BUCKETS   (2 * EC_GLOB_CACHE_SIZE)
 
-    {
-        int     left_count = 0;
-        int     right_count = 0;
-        for (c = l_pattern; *c; ++ c)
-        {
-            if (*c == '\\' && *(c+1) != '\0')
-            {
-                ++ c;
-                continue;
-            }
-
-            if (*c == '}')
-                ++ right_count;
-            if (*c == '{')
-                ++ left_count;
-        }
-
-        are_brace_paired = (right_count == left_count);
-    }
+/*
+ * Process-wide cache of compiled patterns, keyed by the pattern string. The
+ * LRU list is ordered from the most recently used entry (lru_head) to the
+ * least recently used one (lru_tail), which is evicted first.
+ */
+static struct
+{
+    ec_glob_re*             buckets[EC_GLOB_CACHE_BUCKETS];
+    ec_glob_re*             lru_head;
+    ec_glob_re*             lru_tail;
+    int                     count;
+} glob_cache;
+static ec_mutex glob_cache_mutex = EC_MUTEX_INITIALIZER;
 
-    /* used to search for {num1..num2} case */
-    re = pcre_compile("^\\{[\\+\\-]?\\d+\\.\\.[\\+\\-]?\\d+\\}$", 0,
-            &error_msg, &erroffset, NULL);
-    if (!re)        /* failed to compile */
-        return -1;
+/*
+ * Compile a glob pattern. Return NULL if memory runs out.
+ */
+static ec_glob_re* ec_glob_re_new(const char *pattern, unsigned int hash)
+{
+    ec_glob_re *              gre;
 
-    utarray_new(nums, &ut_int_pair_icd);
+    gre = (ec_glob_re *) calloc(1, sizeof(ec_glob_re));
+    if (!gre)
+        return NULL;
 
-    for (c = l_pattern; *c; ++ c)
+    gre->set = ec_glob_set_new(&pattern, 1);
+    gre->pattern = strdup(pattern);
+    if (!gre->set || !gre->pattern)
     {
-        switch (*c)
-        {
-        case '\\':      /* also skip the next one */
-            if (*(c+1) != '\0')
-            {
-                *(p_pcre ++) = *(c++);
-                *(p_pcre ++) = *c;
-            }
-            else
-                STRING_CAT(p_pcre, "\\\\", pcre_str_end);
-
-            break;
-        case '?':
-            *(p_pcre ++) = '.';
-            break;
-        case '*':
-            if (*(c+1) == '*')      /* case of ** */
-            {
-                STRING_CAT(p_pcre, ".*", pcre_str_end);
-                ++ c;
-            }
-            else                    /* case of * */
-                STRING_CAT(p_pcre, "[^\\/]*", pcre_str_end);
+        ec_glob_set_free(gre->set);
+        free(gre->pattern);
+        free(gre);
+        return NULL;
+    }
+    gre->hash = hash;
+    gre->ref_count = 1;
 
-            break;
-        case '[':
-            if (is_in_bracket)     /* inside brackets, we really mean bracket */
-            {
-                STRING_CAT(p_pcre, "\\[", pcre_str_end);
-                break;
-            }
-
-            {
-                /* check whether we have slash within the bracket */
-                _Bool           has_slash = 0;
-                char *          cc;
-                for (cc = c; *cc && *cc != ']'; ++ cc)
-                {
-                    if (*cc == '\\' && *(cc+1) != '\0')
-                    {
-                        ++ cc;
-                        continue;
-                    }
-
-                    if (*cc == '/')
-                    {
-                        has_slash = 1;
-                        break;
-                    }
-                }
-
-                /* if we have slash in the brackets, just do it literally */
-                if (has_slash)
-                {
-                    char *           right_bracket = strchr(c, ']');
-
-                    strcat(p_pcre, "\\");
-                    strncat(p_pcre, c, right_bracket - c);
-                    strcat(p_pcre, "\\]");
-                    p_pcre += strlen(p_pcre);
-                    c = right_bracket;
-                    break;
-                }
-            }
-
-            is_in_bracket = 1;
-            if (*(c+1) == '!')     /* case of [!...] */
-            {
-                STRING_CAT(p_pcre, "[^", pcre_str_end);
-                ++ c;
-            }
-            else
-                *(p_pcre ++) = '[';
+    return gre;
+}
 
-            break;
+static void ec_glob_re_free(ec_glob_re *gre)
+{
+    ec_glob_set_free(gre->set);
+    free(gre->pattern);
+    free(gre);
+}
 
-        case ']':
-            is_in_bracket = 0;
-            *(p_pcre ++) = *c;
-            break;
 
-        case '-':
-            if (is_in_bracket)      /* in brackets, - indicates range */
-                *(p_pcre ++) = *c;
-            else
-                STRING_CAT(p_pcre, "\\-", pcre_str_end);
+/* Drop one reference of gre. glob_cache_mutex must be held. */
+static void ec_glob_re_unref(ec_glob_re *gre)
+{
+    if (-- gre->ref_count == 0)
+        ec_glob_re_free(gre);
+}
 
-            break;
-        case '{':
-            if (!are_brace_paired)
-            {
-                STRING_CAT(p_pcre, "\\{", pcre_str_end);
-                break;
-            }
-
-            /* Check the case of {single}, where single can be empty */
-            {
-                char *                   cc;
-                _Bool                    is_single = 1;
-
-                for (cc = c + 1; *cc != '\0' && *cc != '}'; ++ cc)
-                {
-                    if (*cc == '\\' && *(cc+1) != '\0')
-                    {
-                        ++ cc;
-                        continue;
-                    }
-
-                    if (*cc == ',')
-                    {
-                        is_single = 0;
-                        break;
-                    }
-                }
-
-                if (*cc == '\0')
-                    is_single = 0;
-
-                if (is_single)      /* escape the { and the corresponding } */
-                {
-                    const char *        double_dots;
-                    int_pair            pair;
-                    int                 pcre_res[3];
-
-                    /* Check the case of {num1..num2} */
-                    rc = pcre_exec(re, NULL, c, (int) (cc - c + 1), 0, 0,
-                            pcre_res, 3);
-
-                    if (rc < 0)    /* not {num1..num2} case */
-                    {
-                        STRING_CAT(p_pcre, "\\{", pcre_str_end);
-
-                        memmove(cc+1, cc, strlen(cc) + 1);
-                        *cc = '\\';
-
-                        break;
-                    }
-
-                    /* Get the range */
-                    double_dots = strstr(c, "..");
-                    pair.num1 = atoi(c + 1);
-                    pair.num2 = atoi(double_dots + 2);
-
-                    utarray_push_back(nums, &pair);
-
-                    STRING_CAT(p_pcre, "([\\+\\-]?\\d+)", pcre_str_end);
-                    c = cc;
-
-                    break;
-                }
-            }
-
-            ++ brace_level;
-            STRING_CAT(p_pcre, "(?:", pcre_str_end);
-            break;
+/* Unlink gre from the LRU list. glob_cache_mutex must be held. */
+static void glob_cache_lru_unlink(ec_glob_re *gre)
+{
+    if (gre->lru_prev)
+        gre->lru_prev->lru_next = gre->lru_next;
+    else
+        glob_cache.lru_head = gre->lru_next;
 
-        case '}':
-            if (!are_brace_paired)
-            {
-                STRING_CAT(p_pcre, "\\}", pcre_str_end);
-                break;
-            }
+    if (gre->lru_next)
+        gre->lru_next->lru_prev = gre->lru_prev;
+    else
+        glob_cache.lru_tail = gre->lru_prev;
 
-            -- brace_level;
-            *(p_pcre ++) = ')';
-            break;
+    gre->lru_prev = gre->lru_next = NULL;
+}
 
-        case ',':
-            if (brace_level > 0)  /* , inside {...} */
-                *(p_pcre ++) = '|';
-            else
-                STRING_CAT(p_pcre, "\\,", pcre_str_end);
-            break;
+/* Make gre the most recently used entry. glob_cache_mutex must be held. */
+static void glob_cache_lru_push_front(ec_glob_re *gre)
+{
+    gre->lru_prev = NULL;
+    gre->lru_next = glob_cache.lru_head;
+    if (glob_cache.lru_head)
+        glob_cache.lru_head->lru_prev = gre;
+    glob_cache.lru_head = gre;
+    if (!glob_cache.lru_tail)
+        glob_cache.lru_tail = gre;
+}
 
-        case '/':
-            // /**/ case, match both single / and /anything/
-            if (!strncmp(c, "/**/", 4))
-            {
-                STRING_CAT(p_pcre, "(\\/|\\/.*\\/)", pcre_str_end);
-                c += 3;
-            }
-            else
-                STRING_CAT(p_pcre, "\\/", pcre_str_end);
+/* Remove gre from the cache. glob_cache_mutex must be held. */
+static void glob_cache_remove(ec_glob_re *gre)
+{
+    ec_glob_re **             pp;
 
+    for (pp = &glob_cache.buckets[gre->hash % EC_GLOB_CACHE_BUCKETS]; *pp;
+            pp = &(*pp)->hash_next)
+    {
+        if (*pp == gre)
+        {
+            *pp = gre->hash_next;
             break;
-
-        default:
-            if (!isalnum(*c))
-                *(p_pcre ++) = '\\';
-
-            *(p_pcre ++) = *c;
         }
     }
 
-    *(p_pcre ++) = '$';
+    glob_cache_lru_unlink(gre);
+    -- glob_cache.count;
+    ec_glob_re_unref(gre);
+}
 
-    pcre_free(re); /* ^\\d+\\.\\.\\d+$ */
+/* Look up pattern in the cache. glob_cache_mutex must be held. */
+static ec_glob_re* glob_cache_find(const char *pattern, unsigned int hash)
+{
+    ec_glob_re *              gre;
 
-    re = pcre_compile(pcre_str, 0, &error_msg, &erroffset, NULL);
+    for (gre = glob_cache.buckets[hash % EC_GLOB_CACHE_BUCKETS]; gre;
+            gre = gre->hash_next)
+        if (gre->hash == hash && !strcmp(gre->pattern, pattern))
+            return gre;
 
-    if (!re)        /* failed to compile */
-        return -1;
+    return NULL;
+}
 
-    pcre_result_len = 3 * (utarray_len(nums) + 1);
-    pcre_result = (int *) calloc(pcre_result_len, sizeof(int_pair));
-    rc = pcre_exec(re, NULL, string, (int) strlen(string), 0, 0,
-            pcre_result, pcre_result_len);
+/*
+ * Get the compiled form of pattern, compiling it if it is not in the cache
+ * yet. The returned pattern must be released with ec_glob_re_release().
+ */
+static ec_glob_re* ec_glob_re_acquire(const char *pattern)
+{
+    unsigned int              hash = ec_str_hash(pattern);
+    ec_glob_re *              gre;
+    ec_glob_re *              new_gre;
 
-    if (rc < 0)     /* failed to match */
+    ec_mutex_lock(&glob_cache_mutex);
+    gre = glob_cache_find(pattern, hash);
+    if (gre)
     {
-        int         ret;
-        if (rc == PCRE_ERROR_NOMATCH)
-            ret = EC_GLOB_NOMATCH;
-        else
-            ret = rc;
+        glob_cache_lru_unlink(gre);
+        glob_cache_lru_push_front(gre);
+        ++ gre->ref_count;
+    }
+    ec_mutex_unlock(&glob_cache_mutex);
 
-        pcre_free(re);
-        free(pcre_result);
-        utarray_free(nums);
+    if (gre)
+        return gre;
 
-        return ret;
-    }
+    /* compile without holding the lock */
+    new_gre = ec_glob_re_new(pattern, hash);
+    if (!new_gre)
+        return NULL;
 
-    /* Whether the numbers are in the desired range? */
-    for(p = (int_pair *) utarray_front(nums), i = 1; p;
-            ++ i, p = (int_pair *) utarray_next(nums, p))
+    ec_mutex_lock(&glob_cache_mutex);
+    /* another thread may have compiled the same pattern in the meantime */
+    gre = glob_cache_find(pattern, hash);
+    if (gre)
     {
-        const char * substring_start = string + pcre_result[2 * i];
-        size_t  substring_length = pcre_result[2 * i + 1] - pcre_result[2 * i];
-        char *       num_string;
-        int          num;
+        glob_cache_lru_unlink(gre);
+        glob_cache_lru_push_front(gre);
+        ++ gre->ref_count;
+        ec_glob_re_unref(new_gre);
+    }
+    else
+    {
+        gre = new_gre;
+        if (glob_cache.count >= EC_GLOB_CACHE_SIZE)
+            glob_cache_remove(glob_cache.lru_tail);
+
+        gre->hash_next = glob_cache.buckets[hash % EC_GLOB_CACHE_BUCKETS];
+        glob_cache.buckets[hash % EC_GLOB_CACHE_BUCKETS] = gre;
+        glob_cache_lru_push_front(gre);
+        ++ gre->ref_count;      /* the reference held by the cache */
+        ++ glob_cache.count;
+    }
+    ec_mutex_unlock(&glob_cache_mutex);
 
-        /* we don't consider 0digits such as 010 as matched */
-        if (*substring_start == '0')
-            break;
+    return gre;
+}
 
-        num_string = strndup(substring_start, substring_length);
-        num = atoi(num_string);
-        free(num_string);
+static void ec_glob_re_release(ec_glob_re *gre)
+{
+    ec_mutex_lock(&glob_cache_mutex);
+    ec_glob_re_unref(gre);
+    ec_mutex_unlock(&glob_cache_mutex);
+}
 
-        if (num < p->num1 || num > p->num2) /* not matched */
-            break;
-    }
+/*
+ * Whether the string matches the given glob pattern
+ */
+EDITORCONFIG_LOCAL
+int ec_glob(const char *pattern, const char *string)
+{
+    ec_glob_re *              gre;
+    unsigned char             matched;
+    int                       ret;
+
+    gre = ec_glob_re_acquire(pattern);
+    if (!gre)
+        return -1;
 
-    if (p != NULL)      /* numbers not matched */
-        ret = EC_GLOB_NOMATCH;
+    ret = ec_glob_set_match(gre->set, string, NULL, &matched);
+    ec_glob_re_release(gre);
 
-    pcre_free(re);
-    free(pcre_result);
-    utarray_free(nums);
+    if (ret != 0)
+        return ret;
 
-    return ret;
+    return matched ? 0 : EC_GLOB_NOMATCH;
 }
@@ -36,6 +36,33 @@ extern "C" {
 #endif
 EDITORCONFIG_LOCAL
 int ec_glob(const char * pattern, const char * string);
+
+/*
+ * A set of glob patterns matched against a string in a single pass. The set
+ * is implemented by the builtin glob engine in ec_glob_native.c, or by
+ * ec_glob_pcre.c if the USE_PCRE option is on.
+ */
+typedef struct ec_glob_set ec_glob_set;
+
+/*
+ * Compile count glob patterns into a set. An invalid pattern never matches.
+ * Return NULL if memory runs out.
+ */
+EDITORCONFIG_LOCAL
+ec_glob_set* ec_glob_set_new(const char * const * patterns, int count);
+
+/*
+ * Set matched[i] to 1 if the string matches the ith pattern of the set, and
+ * to 0 otherwise. If wanted is not NULL, the ith pattern is only matched if
+ * wanted[i] is not 0, matched[i] being 0 otherwise. Return 0 on success, -1
+ * if memory runs out.
+ */
+EDITORCONFIG_LOCAL
+int ec_glob_set_match(const ec_glob_set * set, const char * string,
+        const unsigned char * wanted, unsigned char * matched);
+
+EDITORCONFIG_LOCAL
+void ec_glob_set_free(ec_glob_set * set);
 #ifdef __cplusplus
 }
 #endif
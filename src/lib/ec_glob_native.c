@@ -0,0 +1,1057 @@
+/*
+ * Copyright (c) 2014 Hong Xu <hong AT topbug DOT net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * The builtin glob engine. The glob patterns of a set are compiled into one
+ * program of a small matching machine, and a string is run through the
+ * program by a backtracking search which never visits the same (instruction,
+ * position) state twice. Matching a string of length n against a program of
+ * m instructions thus takes O(m * n) steps at most, whatever the patterns
+ * are.
+ */
+
+#include "global.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <string.h>
+
+#include "ec_glob.h"
+
+enum
+{
+    OP_CHAR,        /* the character x */
+    OP_ANY,         /* any character */
+    OP_CLASS,       /* a character of the class x */
+    OP_STAR,        /* any string without '/' */
+    OP_DOUBLE_STAR, /* any string */
+    OP_NUM,         /* an integer in the range x */
+    OP_FORK,        /* continue at both the next instruction and x, if x >= 0 */
+    OP_JMP,         /* continue at x */
+    OP_MATCH        /* the pattern x matches if the string ends here */
+};
+
+typedef struct ec_glob_inst
+{
+    int                     op;
+    int                     x;
+} ec_glob_inst;
+
+typedef struct int_pair
+{
+    int     num1;
+    int     num2;
+} int_pair;
+
+/* a set of characters, one bit for each */
+typedef struct char_class
+{
+    unsigned char           bits[(UCHAR_MAX + 1) / CHAR_BIT];
+} char_class;
+
+#define CLASS_HAS(cls, ch) \
+    ((cls)->bits[(unsigned char) (ch) / CHAR_BIT] & \
+     (1 << ((unsigned char) (ch) % CHAR_BIT)))
+#define CLASS_ADD(cls, ch) \
+    ((cls)->bits[(unsigned char) (ch) / CHAR_BIT] |= \
+     (1 << ((unsigned char) (ch) % CHAR_BIT)))
+
+/* a literal string stored in the literals of a set */
+typedef struct glob_literal
+{
+    int                     offset;
+    int                     len;
+} glob_literal;
+
+/*
+ * A compiled pattern. Before running the program of a pattern, the string is
+ * checked against the literal prefix and suffixes every match of the pattern
+ * has, which rejects most strings at the cost of a memcmp.
+ */
+typedef struct glob_pattern
+{
+    int                     start;      /* -1 if the pattern is invalid */
+    int                     end;        /* past the last instruction */
+    glob_literal            prefix;
+    /* a match ends with one of the suffixes; none if suffix_count is 0 */
+    int                     suffixes;
+    int                     suffix_count;
+} glob_pattern;
+
+struct ec_glob_set
+{
+    int                     count;
+    glob_pattern *          patterns;
+    ec_glob_inst *          insts;
+    int                     inst_count;
+    int                     inst_capacity;
+    char_class *            classes;
+    int                     class_count;
+    int                     class_capacity;
+    int_pair *              ranges;
+    int                     range_count;
+    int                     range_capacity;
+    char *                  literals;
+    int                     literals_len;
+    int                     literals_capacity;
+    glob_literal *          suffixes;
+    int                     suffix_count;
+    int                     suffix_capacity;
+};
+
+/*
+ * Make room for one more element in the growing array *array. Return -1 if
+ * memory runs out.
+ */
+static int array_reserve(void **array, int count, int *capacity,
+        size_t element_size)
+{
+    void *                    new_array;
+    int                       new_capacity;
+
+    if (count < *capacity)
+        return 0;
+
+    new_capacity = *capacity ? 2 * *capacity : 16;
+    new_array = realloc(*array, new_capacity * element_size);
+    if (!new_array)
+        return -1;
+
+    *array = new_array;
+    *capacity = new_capacity;
+    return 0;
+}
+
+/* Append an instruction. Return its index, or -1 if memory runs out. */
+static int emit(ec_glob_set *set, int op, int x)
+{
+    if (array_reserve((void **) &set->insts, set->inst_count,
+                &set->inst_capacity, sizeof(ec_glob_inst)) != 0)
+        return -1;
+
+    set->insts[set->inst_count].op = op;
+    set->insts[set->inst_count].x = x;
+    return set->inst_count ++;
+}
+
+/* Append an empty character class. Return its index, or -1 if memory runs
+ * out. */
+static int new_class(ec_glob_set *set)
+{
+    if (array_reserve((void **) &set->classes, set->class_count,
+                &set->class_capacity, sizeof(char_class)) != 0)
+        return -1;
+
+    memset(&set->classes[set->class_count], 0, sizeof(char_class));
+    return set->class_count ++;
+}
+
+/* Append a number range. Return its index, or -1 if memory runs out. */
+static int new_range(ec_glob_set *set, int num1, int num2)
+{
+    if (array_reserve((void **) &set->ranges, set->range_count,
+                &set->range_capacity, sizeof(int_pair)) != 0)
+        return -1;
+
+    set->ranges[set->range_count].num1 = num1;
+    set->ranges[set->range_count].num2 = num2;
+    return set->range_count ++;
+}
+
+/* Whether the string from c to cc matches {[+-]?\d+\.\.[+-]?\d+} */
+static _Bool is_num_range(const char *c, const char *cc)
+{
+    int                       i;
+
+    ++ c;       /* skip { */
+    for (i = 0; i < 2; ++ i)
+    {
+        if (*c == '+' || *c == '-')
+            ++ c;
+        if (!isdigit(*c))
+            return 0;
+        while (isdigit(*c))
+            ++ c;
+
+        if (i == 0)
+        {
+            if (strncmp(c, "..", 2))
+                return 0;
+            c += 2;
+        }
+    }
+
+    return c == cc;
+}
+
+/*
+ * Parse the bracket expression starting at *pc into a new character class.
+ * On return, *pc points to the closing bracket. Return the index of the
+ * class, -1 if memory runs out, or -2 if the bracket is invalid.
+ */
+static int compile_bracket(ec_glob_set *set, const char **pc)
+{
+    const char *              c = *pc + 1;
+    _Bool                     is_negative = 0;
+    _Bool                     is_first = 1;
+    char_class *              cls;
+    int                       cls_index;
+    size_t                    i;
+
+    cls_index = new_class(set);
+    if (cls_index < 0)
+        return -1;
+    cls = &set->classes[cls_index];
+
+    if (*c == '!')     /* case of [!...] */
+    {
+        is_negative = 1;
+        ++ c;
+    }
+
+    /* a closing bracket right after the opening one is a character */
+    for (; *c != ']' || is_first; ++ c, is_first = 0)
+    {
+        unsigned char         first;
+        unsigned char         last;
+
+        if (*c == '\0')
+            return -2;
+
+        if (*c == '\\' && *(c+1) != '\0')
+            ++ c;
+        first = last = *c;
+
+        /* a range, unless - is the last character of the bracket */
+        if (*(c+1) == '-' && *(c+2) != '\0' && *(c+2) != ']')
+        {
+            c += 2;
+            if (*c == '\\' && *(c+1) != '\0')
+                ++ c;
+            last = *c;
+            if (first > last)       /* a range out of order */
+                return -2;
+        }
+
+        for (i = first; i <= last; ++ i)
+            CLASS_ADD(cls, i);
+    }
+
+    if (is_negative)
+        for (i = 0; i < sizeof(cls->bits); ++ i)
+            cls->bits[i] = (unsigned char) ~cls->bits[i];
+
+    *pc = c;
+    return cls_index;
+}
+
+/* a group of braces being compiled */
+typedef struct brace_group
+{
+    int                     fork;       /* the fork of the last alternative */
+    int                     jmps;       /* chain of the jumps to the end */
+} brace_group;
+
+/*
+ * Compile a glob pattern into the program of set, as the pattern index.
+ * Return 0 on success, -1 if memory runs out, or -2 if the pattern is
+ * invalid.
+ */
+static int compile_pattern(ec_glob_set *set, const char *pattern, int index)
+{
+    char *                    l_pattern;
+    char *                    c;
+    brace_group *             groups;
+    int                       brace_level = 0;
+    _Bool                     are_brace_paired;
+    int                       ret = -1;
+    size_t                    pattern_len = strlen(pattern);
+
+    /* each {single} may grow the pattern by the escape of its } */
+    l_pattern = (char *) malloc(2 * pattern_len + 1);
+    groups = (brace_group *) malloc((pattern_len + 1) * sizeof(brace_group));
+    if (!l_pattern || !groups)
+        goto cleanup;
+    strcpy(l_pattern, pattern);
+
+    {
+        int     left_count = 0;
+        int     right_count = 0;
+        for (c = l_pattern; *c; ++ c)
+        {
+            if (*c == '\\' && *(c+1) != '\0')
+            {
+                ++ c;
+                continue;
+            }
+
+            if (*c == '}')
+                ++ right_count;
+            if (*c == '{')
+                ++ left_count;
+        }
+
+        are_brace_paired = (right_count == left_count);
+    }
+
+#define EMIT(op, x)  do { \
+    if (emit(set, (op), (x)) < 0) \
+        goto cleanup; \
+} while(0)
+
+    for (c = l_pattern; *c; ++ c)
+    {
+        switch (*c)
+        {
+        case '\\':      /* also skip the next one */
+            if (*(c+1) != '\0')
+                ++ c;
+            EMIT(OP_CHAR, (unsigned char) *c);
+            break;
+        case '?':
+            EMIT(OP_ANY, 0);
+            break;
+        case '*':
+            if (*(c+1) == '*')      /* case of ** */
+            {
+                EMIT(OP_DOUBLE_STAR, 0);
+                ++ c;
+            }
+            else                    /* case of * */
+                EMIT(OP_STAR, 0);
+
+            break;
+        case '[':
+            {
+                /* check whether we have slash within the bracket */
+                _Bool           has_slash = 0;
+                char *          cc;
+                int             cls;
+
+                for (cc = c; *cc && *cc != ']'; ++ cc)
+                {
+                    if (*cc == '\\' && *(cc+1) != '\0')
+                    {
+                        ++ cc;
+                        continue;
+                    }
+
+                    if (*cc == '/')
+                    {
+                        has_slash = 1;
+                        break;
+                    }
+                }
+
+                /* if we have slash in the brackets, just do it literally */
+                if (has_slash)
+                {
+                    char *           right_bracket = strchr(c, ']');
+
+                    if (!right_bracket)     /* no closing bracket */
+                    {
+                        EMIT(OP_CHAR, '[');
+                        break;
+                    }
+
+                    for (; c < right_bracket; ++ c)
+                        EMIT(OP_CHAR, (unsigned char) *c);
+                    EMIT(OP_CHAR, ']');
+                    break;
+                }
+
+                cls = compile_bracket(set, (const char **) &c);
+                if (cls == -2)
+                {
+                    ret = -2;
+                    goto cleanup;
+                }
+                if (cls < 0)
+                    goto cleanup;
+                EMIT(OP_CLASS, cls);
+            }
+            break;
+
+        case '{':
+            if (!are_brace_paired)
+            {
+                EMIT(OP_CHAR, '{');
+                break;
+            }
+
+            /* Check the case of {single}, where single can be empty */
+            {
+                char *                   cc;
+                _Bool                    is_single = 1;
+
+                for (cc = c + 1; *cc != '\0' && *cc != '}'; ++ cc)
+                {
+                    if (*cc == '\\' && *(cc+1) != '\0')
+                    {
+                        ++ cc;
+                        continue;
+                    }
+
+                    if (*cc == ',')
+                    {
+                        is_single = 0;
+                        break;
+                    }
+                }
+
+                if (*cc == '\0')
+                    is_single = 0;
+
+                if (is_single)      /* escape the { and the corresponding } */
+                {
+                    int                 range;
+
+                    /* Check the case of {num1..num2} */
+                    if (!is_num_range(c, cc))
+                    {
+                        EMIT(OP_CHAR, '{');
+
+                        memmove(cc+1, cc, strlen(cc) + 1);
+                        *cc = '\\';
+
+                        break;
+                    }
+
+                    /* Get the range */
+                    range = new_range(set, atoi(c + 1),
+                            atoi(strstr(c, "..") + 2));
+                    if (range < 0)
+                        goto cleanup;
+                    EMIT(OP_NUM, range);
+                    c = cc;
+
+                    break;
+                }
+            }
+
+            /* the fork to the next alternative is patched when , is met */
+            groups[brace_level].fork = set->inst_count;
+            groups[brace_level].jmps = -1;
+            ++ brace_level;
+            EMIT(OP_FORK, -1);
+            break;
+
+        case '}':
+            if (!are_brace_paired)
+            {
+                EMIT(OP_CHAR, '}');
+                break;
+            }
+
+            if (brace_level == 0)   /* } without { */
+            {
+                ret = -2;
+                goto cleanup;
+            }
+
+            /* make all the alternatives continue here */
+            {
+                brace_group *       group = &groups[-- brace_level];
+                int                 jmp = group->jmps;
+
+                while (jmp >= 0)
+                {
+                    int     next = set->insts[jmp].x;
+
+                    set->insts[jmp].x = set->inst_count;
+                    jmp = next;
+                }
+            }
+            break;
+
+        case ',':
+            if (brace_level > 0)  /* , inside {...} */
+            {
+                brace_group *       group = &groups[brace_level - 1];
+                int                 jmp = set->inst_count;
+
+                EMIT(OP_JMP, group->jmps);
+                group->jmps = jmp;
+                set->insts[group->fork].x = set->inst_count;
+                group->fork = set->inst_count;
+                EMIT(OP_FORK, -1);
+            }
+            else
+                EMIT(OP_CHAR, ',');
+            break;
+
+        case '/':
+            // /**/ case, match both single / and /anything/
+            if (!strncmp(c, "/**/", 4))
+            {
+                int                 fork;
+
+                EMIT(OP_CHAR, '/');
+                fork = set->inst_count;
+                EMIT(OP_FORK, -1);
+                EMIT(OP_DOUBLE_STAR, 0);
+                EMIT(OP_CHAR, '/');
+                set->insts[fork].x = set->inst_count;
+                c += 3;
+            }
+            else
+                EMIT(OP_CHAR, '/');
+
+            break;
+
+        default:
+            EMIT(OP_CHAR, (unsigned char) *c);
+        }
+    }
+
+    if (brace_level > 0)        /* unclosed { */
+    {
+        ret = -2;
+        goto cleanup;
+    }
+
+    EMIT(OP_MATCH, index);
+#undef EMIT
+
+    ret = 0;
+
+cleanup:
+    free(l_pattern);
+    free(groups);
+    return ret;
+}
+
+/* Max count and length of the literal suffixes kept for a pattern */
+#define SUFFIX_MAX_COUNT    8
+#define SUFFIX_MAX_LEN      32
+
+/*
+ * The literal suffixes the matches from an instruction end with. The
+ * characters of each suffix are stored in reverse order, since they are
+ * collected from the end of the program. A suffix is open while it can
+ * still be extended by the characters preceding it, and count is -1 when
+ * the matches have no common literal suffixes.
+ */
+typedef struct suffix_list
+{
+    int                     count;
+    struct
+    {
+        char                rev[SUFFIX_MAX_LEN];
+        int                 len;
+        _Bool               is_open;
+    }                       items[SUFFIX_MAX_COUNT];
+} suffix_list;
+
+/* Add the suffixes of from to to */
+static void suffix_list_merge(suffix_list *to, const suffix_list *from)
+{
+    int                       i;
+    int                       j;
+
+    if (to->count < 0 || from->count < 0)
+    {
+        to->count = -1;
+        return;
+    }
+
+    for (i = 0; i < from->count; ++ i)
+    {
+        for (j = 0; j < to->count; ++ j)
+            if (to->items[j].len == from->items[i].len &&
+                    to->items[j].is_open == from->items[i].is_open &&
+                    !memcmp(to->items[j].rev, from->items[i].rev,
+                        from->items[i].len))
+                break;
+
+        if (j < to->count)      /* already there */
+            continue;
+
+        if (to->count == SUFFIX_MAX_COUNT)
+        {
+            to->count = -1;
+            return;
+        }
+        to->items[to->count ++] = from->items[i];
+    }
+}
+
+/* Append a literal to the literals of set. Return -1 if memory runs out. */
+static int add_literal(ec_glob_set *set, glob_literal *literal,
+        const char *chars, int len)
+{
+    if (set->literals_len + len > set->literals_capacity)
+    {
+        int         new_capacity = 2 * (set->literals_len + len);
+        char *      new_literals = (char *) realloc(set->literals,
+                new_capacity);
+
+        if (!new_literals)
+            return -1;
+        set->literals = new_literals;
+        set->literals_capacity = new_capacity;
+    }
+
+    memcpy(set->literals + set->literals_len, chars, len);
+    literal->offset = set->literals_len;
+    literal->len = len;
+    set->literals_len += len;
+    return 0;
+}
+
+/*
+ * Find the literal prefix and suffixes of the compiled pattern pat. Return
+ * -1 if memory runs out.
+ */
+static int find_literals(ec_glob_set *set, glob_pattern *pat)
+{
+    suffix_list *             lists;
+    int                       pc;
+    int                       i;
+    int                       ret = -1;
+
+    /* the prefix is made of the characters the program starts with */
+    for (pc = pat->start; set->insts[pc].op == OP_CHAR; ++ pc)
+        ;
+    {
+        char *                prefix = (char *) malloc(pc - pat->start + 1);
+        int                   len = pc - pat->start;
+
+        if (!prefix)
+            return -1;
+        for (i = 0; i < len; ++ i)
+            prefix[i] = (char) set->insts[pat->start + i].x;
+        ret = add_literal(set, &pat->prefix, prefix, len);
+        free(prefix);
+        if (ret != 0)
+            return -1;
+    }
+
+    /* Jumps and forks only go forward, so the suffixes of each instruction
+     * are known once those of the following instructions are. */
+    lists = (suffix_list *) malloc((pat->end - pat->start) *
+            sizeof(suffix_list));
+    if (!lists)
+        return -1;
+
+    for (pc = pat->end - 1; pc >= pat->start; -- pc)
+    {
+        const ec_glob_inst *  inst = &set->insts[pc];
+        suffix_list *         list = &lists[pc - pat->start];
+
+        switch (inst->op)
+        {
+        case OP_MATCH:
+            list->count = 1;
+            list->items[0].len = 0;
+            list->items[0].is_open = 1;
+            break;
+        case OP_CHAR:
+            *list = lists[pc + 1 - pat->start];
+            for (i = 0; i < list->count; ++ i)
+            {
+                if (!list->items[i].is_open)
+                    continue;
+
+                if (list->items[i].len == SUFFIX_MAX_LEN)
+                    list->items[i].is_open = 0;
+                else
+                    list->items[i].rev[list->items[i].len ++] =
+                        (char) inst->x;
+            }
+            break;
+        case OP_FORK:
+            *list = lists[pc + 1 - pat->start];
+            if (inst->x >= 0)
+                suffix_list_merge(list, &lists[inst->x - pat->start]);
+            break;
+        case OP_JMP:
+            *list = lists[inst->x - pat->start];
+            break;
+        default:    /* the instructions which are not literal */
+            *list = lists[pc + 1 - pat->start];
+            for (i = 0; i < list->count; ++ i)
+                list->items[i].is_open = 0;
+        }
+    }
+
+    pat->suffix_count = 0;
+    {
+        const suffix_list *   list = &lists[0];
+
+        /* an empty suffix rejects nothing */
+        for (i = 0; i < list->count; ++ i)
+            if (list->items[i].len == 0)
+                break;
+
+        if (list->count > 0 && i == list->count)
+        {
+            pat->suffixes = set->suffix_count;
+            for (i = 0; i < list->count; ++ i)
+            {
+                char          chars[SUFFIX_MAX_LEN];
+                int           len = list->items[i].len;
+                int           j;
+
+                if (array_reserve((void **) &set->suffixes,
+                            set->suffix_count, &set->suffix_capacity,
+                            sizeof(glob_literal)) != 0)
+                    goto cleanup;
+
+                for (j = 0; j < len; ++ j)
+                    chars[j] = list->items[i].rev[len - 1 - j];
+                if (add_literal(set, &set->suffixes[set->suffix_count],
+                            chars, len) != 0)
+                    goto cleanup;
+                ++ set->suffix_count;
+                ++ pat->suffix_count;
+            }
+        }
+    }
+
+    ret = 0;
+
+cleanup:
+    free(lists);
+    return ret;
+}
+
+/*
+ * Whether the string of length len has the literal prefix and one of the
+ * literal suffixes of pat
+ */
+static _Bool has_literals(const ec_glob_set *set, const glob_pattern *pat,
+        const char *string, int len)
+{
+    int                       i;
+
+    if (pat->prefix.len > len || memcmp(string,
+                set->literals + pat->prefix.offset, pat->prefix.len))
+        return 0;
+
+    if (pat->suffix_count == 0)
+        return 1;
+
+    for (i = 0; i < pat->suffix_count; ++ i)
+    {
+        const glob_literal *  suffix = &set->suffixes[pat->suffixes + i];
+
+        if (suffix->len <= len &&
+                !memcmp(string + len - suffix->len,
+                    set->literals + suffix->offset, suffix->len))
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+ec_glob_set* ec_glob_set_new(const char * const *patterns, int count)
+{
+    ec_glob_set *             set;
+    int                       i;
+
+    set = (ec_glob_set *) calloc(1, sizeof(ec_glob_set));
+    if (!set)
+        return NULL;
+
+    set->count = count;
+    set->patterns = (glob_pattern *) calloc(count + 1, sizeof(glob_pattern));
+    if (!set->patterns)
+        goto fail;
+
+    for (i = 0; i < count; ++i)
+    {
+        glob_pattern *        pat = &set->patterns[i];
+        int                   rc;
+
+        pat->start = set->inst_count;
+        rc = compile_pattern(set, patterns[i], i);
+        if (rc == -2)
+        {
+            /* an invalid pattern never matches; drop what was compiled */
+            set->inst_count = pat->start;
+            pat->start = -1;
+            continue;
+        }
+        else if (rc != 0)
+            goto fail;
+
+        pat->end = set->inst_count;
+        if (find_literals(set, pat) != 0)
+            goto fail;
+    }
+
+    return set;
+
+fail:
+    ec_glob_set_free(set);
+    return NULL;
+}
+
+/* a state of the search: continue at instruction pc, position pos */
+typedef struct match_job
+{
+    int                     pc;
+    int                     pos;
+} match_job;
+
+/* Max count of states whose visited bits or jobs fit on the stack */
+#define MATCH_STATES_ON_STACK   (8 * 1024)
+#define MATCH_JOBS_ON_STACK     64
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+int ec_glob_set_match(const ec_glob_set *set, const char *string,
+        const unsigned char *wanted, unsigned char *matched)
+{
+    unsigned char             visited_stack[MATCH_STATES_ON_STACK / CHAR_BIT];
+    unsigned char *           visited = visited_stack;
+    size_t                    visited_size;
+    match_job                 jobs_stack[MATCH_JOBS_ON_STACK];
+    match_job *               jobs = jobs_stack;
+    int                       job_count = 0;
+    int                       job_capacity = MATCH_JOBS_ON_STACK;
+    int                       len = (int) strlen(string);
+    int                       remaining = 0;
+    int                       first_inst = set->inst_count;
+    int                       last_inst = 0;
+    int                       ret = 0;
+    int                       i;
+
+    /* Only the patterns wanted whose literals the string has are run. They
+     * are marked with 2 in matched until the search starts. */
+    for (i = 0; i < set->count; ++ i)
+    {
+        const glob_pattern *  pat = &set->patterns[i];
+
+        matched[i] = 0;
+        if (pat->start < 0 || (wanted && !wanted[i]) ||
+                !has_literals(set, pat, string, len))
+            continue;
+
+        matched[i] = 2;
+        ++ remaining;
+        if (pat->start < first_inst)
+            first_inst = pat->start;
+        if (pat->end > last_inst)
+            last_inst = pat->end;
+    }
+
+    if (remaining == 0)
+        return 0;
+
+    /* the visited bits of the instructions from first_inst to last_inst */
+    visited_size = ((size_t) (last_inst - first_inst) * (len + 1) +
+            CHAR_BIT - 1) / CHAR_BIT;
+    if (visited_size > sizeof(visited_stack))
+    {
+        visited = (unsigned char *) malloc(visited_size);
+        if (!visited)
+            return -1;
+    }
+    memset(visited, 0, visited_size);
+
+/* schedule the state (PC, POS) unless it has been visited */
+#define PUSH_JOB(PC, POS)  do { \
+    size_t state = (size_t) ((PC) - first_inst) * (len + 1) + (POS); \
+    if (!(visited[state / CHAR_BIT] & (1 << (state % CHAR_BIT)))) \
+    { \
+        if (job_count == job_capacity) \
+        { \
+            match_job *     new_jobs; \
+            job_capacity *= 2; \
+            if (jobs == jobs_stack) \
+            { \
+                new_jobs = (match_job *) malloc( \
+                        job_capacity * sizeof(match_job)); \
+                if (new_jobs) \
+                    memcpy(new_jobs, jobs, job_count * sizeof(match_job)); \
+            } \
+            else \
+                new_jobs = (match_job *) realloc(jobs, \
+                        job_capacity * sizeof(match_job)); \
+            if (!new_jobs) \
+            { \
+                ret = -1; \
+                goto cleanup; \
+            } \
+            jobs = new_jobs; \
+        } \
+        jobs[job_count].pc = (PC); \
+        jobs[job_count].pos = (POS); \
+        ++ job_count; \
+    } \
+} while(0)
+
+    /* Push the patterns in reverse order so that the first one runs first.
+     * The characters of the prefix are known to match already. */
+    for (i = set->count - 1; i >= 0; -- i)
+    {
+        const glob_pattern *  pat = &set->patterns[i];
+
+        if (matched[i] != 2)
+            continue;
+        matched[i] = 0;
+        PUSH_JOB(pat->start + pat->prefix.len, pat->prefix.len);
+    }
+
+    while (job_count > 0 && remaining > 0)
+    {
+        int                   pc = jobs[job_count - 1].pc;
+        int                   pos = jobs[job_count - 1].pos;
+
+        -- job_count;
+
+        /* follow one path, scheduling the others */
+        for (;;)
+        {
+            size_t                state = (size_t) (pc - first_inst) *
+                (len + 1) + pos;
+            const ec_glob_inst *  inst = &set->insts[pc];
+
+            if (visited[state / CHAR_BIT] & (1 << (state % CHAR_BIT)))
+                break;
+            visited[state / CHAR_BIT] |= 1 << (state % CHAR_BIT);
+
+            if (inst->op == OP_CHAR)
+            {
+                if (pos == len || (unsigned char) string[pos] != inst->x)
+                    break;
+                ++ pc;
+                ++ pos;
+            }
+            else if (inst->op == OP_ANY)
+            {
+                if (pos == len)
+                    break;
+                ++ pc;
+                ++ pos;
+            }
+            else if (inst->op == OP_CLASS)
+            {
+                if (pos == len || !CLASS_HAS(&set->classes[inst->x],
+                            string[pos]))
+                    break;
+                ++ pc;
+                ++ pos;
+            }
+            else if (inst->op == OP_STAR)
+            {
+                PUSH_JOB(pc + 1, pos);
+                if (pos == len || string[pos] == '/')
+                    break;
+                ++ pos;
+            }
+            else if (inst->op == OP_DOUBLE_STAR)
+            {
+                PUSH_JOB(pc + 1, pos);
+                if (pos == len)
+                    break;
+                ++ pos;
+            }
+            else if (inst->op == OP_NUM)
+            {
+                const int_pair *      range = &set->ranges[inst->x];
+                int                   sign = 1;
+                long                  num = 0;
+
+                /* we don't consider 0digits such as 010 as matched */
+                if (string[pos] == '0')
+                    break;
+
+                if (string[pos] == '+' || string[pos] == '-')
+                {
+                    if (string[pos] == '-')
+                        sign = -1;
+                    ++ pos;
+                }
+
+                if (!isdigit(string[pos]))
+                    break;
+
+                /* the number is made of all the digits that follow */
+                for (; isdigit(string[pos]); ++ pos)
+                    if (num <= INT_MAX)
+                        num = 10 * num + (string[pos] - '0');
+
+                if (num > INT_MAX || sign * num < range->num1 ||
+                        sign * num > range->num2)
+                    break;
+                ++ pc;
+            }
+            else if (inst->op == OP_FORK)
+            {
+                if (inst->x >= 0)
+                    PUSH_JOB(inst->x, pos);
+                ++ pc;
+            }
+            else if (inst->op == OP_JMP)
+                pc = inst->x;
+            else    /* OP_MATCH */
+            {
+                if (pos == len && !matched[inst->x])
+                {
+                    matched[inst->x] = 1;
+                    -- remaining;
+                }
+                break;
+            }
+        }
+    }
+#undef PUSH_JOB
+
+cleanup:
+    if (visited != visited_stack)
+        free(visited);
+    if (jobs != jobs_stack)
+        free(jobs);
+
+    return ret;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_glob_set_free(ec_glob_set *set)
+{
+    if (!set)
+        return;
+
+    free(set->patterns);
+    free(set->insts);
+    free(set->classes);
+    free(set->ranges);
+    free(set->literals);
+    free(set->suffixes);
+    free(set);
+}
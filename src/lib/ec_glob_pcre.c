@@ -0,0 +1,613 @@
+/*
+ * Copyright (c) 2014 Hong Xu <hong AT topbug DOT net>
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "global.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <pcre.h>
+
+#include "utarray.h"
+#include "misc.h"
+
+#include "ec_glob.h"
+
+typedef struct int_pair
+{
+    int     num1;
+    int     num2;
+} int_pair;
+static const UT_icd ut_int_pair_icd = {sizeof(int_pair),NULL,NULL,NULL};
+
+/* concatenate the string then move the pointer to the end */
+#define STRING_CAT(p, string, end)  do {    \
+    size_t string_len = strlen(string); \
+    if (p + string_len >= end) \
+        return -1; \
+    strcat(p, string); \
+    p += string_len; \
+} while(0)
+
+#define PATTERN_MAX  300
+
+/*
+ * Translate the glob pattern into a PCRE pattern string. The number ranges
+ * found in the glob are appended to nums, in the order of their capturing
+ * groups.
+ */
+static int ec_glob_translate(const char *pattern, char *pcre_str,
+        UT_array *nums)
+{
+    char *                    c;
+    char *                    p_pcre;
+    char *                    pcre_str_end;
+    int                       brace_level = 0;
+    _Bool                     is_in_bracket = 0;
+    const char *              error_msg;
+    int                       erroffset;
+    pcre *                    re;
+    int                       rc;
+    char                      l_pattern[2 * PATTERN_MAX];
+    _Bool                     are_brace_paired;
+
+    if (strlen(pattern) >= PATTERN_MAX)
+        return -1;
+
+    strcpy(l_pattern, pattern);
+    strcpy(pcre_str, "^");
+    p_pcre = pcre_str + 1;
+    pcre_str_end = pcre_str + 2 * PATTERN_MAX;
+
+    {
+        int     left_count = 0;
+        int     right_count = 0;
+        for (c = l_pattern; *c; ++ c)
+        {
+            if (*c == '\\' && *(c+1) != '\0')
+            {
+                ++ c;
+                continue;
+            }
+
+            if (*c == '}')
+                ++ right_count;
+            if (*c == '{')
+                ++ left_count;
+        }
+
+        are_brace_paired = (right_count == left_count);
+    }
+
+    /* used to search for {num1..num2} case */
+    re = pcre_compile("^\\{[\\+\\-]?\\d+\\.\\.[\\+\\-]?\\d+\\}$", 0,
+            &error_msg, &erroffset, NULL);
+    if (!re)        /* failed to compile */
+        return -1;
+
+    for (c = l_pattern; *c; ++ c)
+    {
+        switch (*c)
+        {
+        case '\\':      /* also skip the next one */
+            if (*(c+1) != '\0')
+            {
+                *(p_pcre ++) = *(c++);
+                *(p_pcre ++) = *c;
+            }
+            else
+                STRING_CAT(p_pcre, "\\\\", pcre_str_end);
+
+            break;
+        case '?':
+            *(p_pcre ++) = '.';
+            break;
+        case '*':
+            if (*(c+1) == '*')      /* case of ** */
+            {
+                STRING_CAT(p_pcre, ".*", pcre_str_end);
+                ++ c;
+            }
+            else                    /* case of * */
+                STRING_CAT(p_pcre, "[^\\/]*", pcre_str_end);
+
+            break;
+        case '[':
+            if (is_in_bracket)     /* inside brackets, we really mean bracket */
+            {
+                STRING_CAT(p_pcre, "\\[", pcre_str_end);
+                break;
+            }
+
+            {
+                /* check whether we have slash within the bracket */
+                _Bool           has_slash = 0;
+                char *          cc;
+                for (cc = c; *cc && *cc != ']'; ++ cc)
+                {
+                    if (*cc == '\\' && *(cc+1) != '\0')
+                    {
+                        ++ cc;
+                        continue;
+                    }
+
+                    if (*cc == '/')
+                    {
+                        has_slash = 1;
+                        break;
+                    }
+                }
+
+                /* if we have slash in the brackets, just do it literally */
+                if (has_slash)
+                {
+                    char *           right_bracket = strchr(c, ']');
+
+                    if (!right_bracket)     /* no closing bracket */
+                    {
+                        STRING_CAT(p_pcre, "\\[", pcre_str_end);
+                        break;
+                    }
+
+                    strcat(p_pcre, "\\");
+                    strncat(p_pcre, c, right_bracket - c);
+                    strcat(p_pcre, "\\]");
+                    p_pcre += strlen(p_pcre);
+                    c = right_bracket;
+                    break;
+                }
+            }
+
+            is_in_bracket = 1;
+            if (*(c+1) == '!')     /* case of [!...] */
+            {
+                STRING_CAT(p_pcre, "[^", pcre_str_end);
+                ++ c;
+            }
+            else
+                *(p_pcre ++) = '[';
+
+            break;
+
+        case ']':
+            is_in_bracket = 0;
+            *(p_pcre ++) = *c;
+            break;
+
+        case '-':
+            if (is_in_bracket)      /* in brackets, - indicates range */
+                *(p_pcre ++) = *c;
+            else
+                STRING_CAT(p_pcre, "\\-", pcre_str_end);
+
+            break;
+        case '{':
+            if (!are_brace_paired)
+            {
+                STRING_CAT(p_pcre, "\\{", pcre_str_end);
+                break;
+            }
+
+            /* Check the case of {single}, where single can be empty */
+            {
+                char *                   cc;
+                _Bool                    is_single = 1;
+
+                for (cc = c + 1; *cc != '\0' && *cc != '}'; ++ cc)
+                {
+                    if (*cc == '\\' && *(cc+1) != '\0')
+                    {
+                        ++ cc;
+                        continue;
+                    }
+
+                    if (*cc == ',')
+                    {
+                        is_single = 0;
+                        break;
+                    }
+                }
+
+                if (*cc == '\0')
+                    is_single = 0;
+
+                if (is_single)      /* escape the { and the corresponding } */
+                {
+                    const char *        double_dots;
+                    int_pair            pair;
+                    int                 pcre_res[3];
+
+                    /* Check the case of {num1..num2} */
+                    rc = pcre_exec(re, NULL, c, (int) (cc - c + 1), 0, 0,
+                            pcre_res, 3);
+
+                    if (rc < 0)    /* not {num1..num2} case */
+                    {
+                        STRING_CAT(p_pcre, "\\{", pcre_str_end);
+
+                        memmove(cc+1, cc, strlen(cc) + 1);
+                        *cc = '\\';
+
+                        break;
+                    }
+
+                    /* Get the range */
+                    double_dots = strstr(c, "..");
+                    pair.num1 = atoi(c + 1);
+                    pair.num2 = atoi(double_dots + 2);
+
+                    utarray_push_back(nums, &pair);
+
+                    STRING_CAT(p_pcre, "([\\+\\-]?\\d+)", pcre_str_end);
+                    c = cc;
+
+                    break;
+                }
+            }
+
+            ++ brace_level;
+            STRING_CAT(p_pcre, "(?:", pcre_str_end);
+            break;
+
+        case '}':
+            if (!are_brace_paired)
+            {
+                STRING_CAT(p_pcre, "\\}", pcre_str_end);
+                break;
+            }
+
+            -- brace_level;
+            *(p_pcre ++) = ')';
+            break;
+
+        case ',':
+            if (brace_level > 0)  /* , inside {...} */
+                *(p_pcre ++) = '|';
+            else
+                STRING_CAT(p_pcre, "\\,", pcre_str_end);
+            break;
+
+        case '/':
+            // /**/ case, match both single / and /anything/
+            if (!strncmp(c, "/**/", 4))
+            {
+                STRING_CAT(p_pcre, "(?:\\/|\\/.*\\/)", pcre_str_end);
+                c += 3;
+            }
+            else
+                STRING_CAT(p_pcre, "\\/", pcre_str_end);
+
+            break;
+
+        default:
+            if (!isalnum(*c))
+                *(p_pcre ++) = '\\';
+
+            *(p_pcre ++) = *c;
+        }
+    }
+
+    *(p_pcre ++) = '$';
+
+    pcre_free(re); /* ^\\d+\\.\\.\\d+$ */
+
+    return 0;
+}
+
+/* Max count of number ranges whose matching results fit on the stack */
+#define RANGE_MAX_ON_STACK 10
+
+/*
+ * Whether the numbers captured by a match are in the desired ranges. The
+ * first number is captured by the group first_group of pcre_result.
+ */
+static _Bool ec_glob_nums_match(const UT_array *nums, const char *string,
+        const int *pcre_result, int first_group)
+{
+    size_t                    i;
+    int_pair *                p;
+
+    for(p = (int_pair *) utarray_front(nums), i = first_group; p;
+            ++ i, p = (int_pair *) utarray_next(nums, p))
+    {
+        const char * substring_start = string + pcre_result[2 * i];
+        size_t  substring_length = pcre_result[2 * i + 1] - pcre_result[2 * i];
+        char *       num_string;
+        int          num;
+
+        /* the range is in an alternative of braces which is not taken */
+        if (pcre_result[2 * i] < 0)
+            continue;
+
+        /* we don't consider 0digits such as 010 as matched */
+        if (*substring_start == '0')
+            break;
+
+        num_string = strndup(substring_start, substring_length);
+        num = atoi(num_string);
+        free(num_string);
+
+        if (num < p->num1 || num > p->num2) /* not matched */
+            break;
+    }
+
+    return p == NULL;
+}
+
+/*
+ * A set of glob patterns compiled into a single PCRE regular expression, which
+ * tells in one pass which of the patterns match a string. Each pattern is
+ * turned into an optional lookahead assertion followed by an empty capturing
+ * group, "(?:(?=pattern$)())?", so that the empty group is set if and only if
+ * the pattern matches. A set of a single pattern is compiled as the plain
+ * translated expression.
+ */
+struct ec_glob_set
+{
+    int                     count;
+    char **                 patterns;
+    /* NULL if the combined expression failed to compile */
+    pcre *                  re;
+    pcre_extra *            re_extra;
+    int                     group_count;
+    /* the number ranges of each pattern */
+    UT_array **             nums;
+    /* the first capturing group of each pattern, -1 if it is invalid */
+    int *                   first_groups;
+};
+
+/* Append string to the growing buffer *buf. Return -1 if memory runs out. */
+static int buffer_append(char **buf, size_t *len, size_t *capacity,
+        const char *string, size_t string_len)
+{
+    if (*len + string_len + 1 > *capacity)
+    {
+        size_t      new_capacity = 2 * (*len + string_len + 1);
+        char *      new_buf = (char *) realloc(*buf, new_capacity);
+
+        if (!new_buf)
+            return -1;
+        *buf = new_buf;
+        *capacity = new_capacity;
+    }
+
+    memcpy(*buf + *len, string, string_len);
+    *len += string_len;
+    (*buf)[*len] = '\0';
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+ec_glob_set* ec_glob_set_new(const char * const *patterns, int count)
+{
+    ec_glob_set *             set;
+    char *                    combined = NULL;
+    size_t                    combined_len = 0;
+    size_t                    combined_capacity = 0;
+    const char *              error_msg;
+    int                       erroffset;
+    int                       i;
+
+    set = (ec_glob_set *) calloc(1, sizeof(ec_glob_set));
+    if (!set)
+        return NULL;
+
+    set->count = count;
+    set->patterns = (char **) calloc(count + 1, sizeof(char *));
+    set->nums = (UT_array **) calloc(count + 1, sizeof(UT_array *));
+    set->first_groups = (int *) calloc(count + 1, sizeof(int));
+    if (!set->patterns || !set->nums || !set->first_groups ||
+            buffer_append(&combined, &combined_len, &combined_capacity,
+                "^", 1) != 0)
+        goto fail;
+
+    for (i = 0; i < count; ++i)
+    {
+        char                  pcre_str[2 * PATTERN_MAX];
+        size_t                pcre_str_len;
+
+        set->patterns[i] = strdup(patterns[i]);
+        if (!set->patterns[i])
+            goto fail;
+        utarray_new(set->nums[i], &ut_int_pair_icd);
+
+        memset(pcre_str, 0, sizeof(pcre_str));
+        if (ec_glob_translate(patterns[i], pcre_str, set->nums[i]) != 0)
+        {
+            /* an invalid pattern never matches */
+            set->first_groups[i] = -1;
+            continue;
+        }
+
+        /* An invalid expression, such as one with an unclosed bracket, would
+         * swallow the patterns following it in the combined expression. */
+        {
+            pcre *            re = pcre_compile(pcre_str, 0, &error_msg,
+                    &erroffset, NULL);
+
+            if (!re)
+            {
+                set->first_groups[i] = -1;
+                continue;
+            }
+            pcre_free(re);
+        }
+
+        pcre_str_len = strlen(pcre_str);
+        if (count == 1)     /* a single pattern needs no lookahead */
+        {
+            if (buffer_append(&combined, &combined_len, &combined_capacity,
+                        pcre_str + 1, pcre_str_len - 1) != 0)
+                goto fail;
+
+            set->first_groups[i] = 1;
+            set->group_count = utarray_len(set->nums[i]);
+            continue;
+        }
+
+        /* strip the ^ and $ surrounding the translated pattern */
+        if (buffer_append(&combined, &combined_len, &combined_capacity,
+                    "(?:(?=(?:", 9) != 0 ||
+                buffer_append(&combined, &combined_len, &combined_capacity,
+                    pcre_str + 1, pcre_str_len - 2) != 0 ||
+                buffer_append(&combined, &combined_len, &combined_capacity,
+                    ")$)())?", 7) != 0)
+            goto fail;
+
+        set->first_groups[i] = set->group_count + 1;
+        set->group_count += utarray_len(set->nums[i]) + 1;
+    }
+
+    /* If the combined expression does not compile, ec_glob_set_match()
+     * falls back to matching the patterns one by one */
+    set->re = pcre_compile(combined, 0, &error_msg, &erroffset, NULL);
+    if (set->re)
+    {
+#ifdef PCRE_STUDY_JIT_COMPILE
+        set->re_extra = pcre_study(set->re, PCRE_STUDY_JIT_COMPILE,
+                &error_msg);
+#else
+        set->re_extra = pcre_study(set->re, 0, &error_msg);
+#endif
+    }
+
+    free(combined);
+    return set;
+
+fail:
+    free(combined);
+    ec_glob_set_free(set);
+    return NULL;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+int ec_glob_set_match(const ec_glob_set *set, const char *string,
+        const unsigned char *wanted, unsigned char *matched)
+{
+    int                       pcre_result_stack[3 * 64];
+    int *                     pcre_result = pcre_result_stack;
+    int                       pcre_result_len;
+    int                       rc = -1;
+    int                       i;
+
+    pcre_result_len = 3 * (set->group_count + 1);
+    if (set->re && pcre_result_len > (int) (sizeof(pcre_result_stack) /
+                sizeof(int)))
+    {
+        pcre_result = (int *) calloc(pcre_result_len, sizeof(int));
+        if (!pcre_result)
+            return -1;
+    }
+
+    if (set->re)
+        rc = pcre_exec(set->re, set->re_extra, string, (int) strlen(string),
+                0, 0, pcre_result, pcre_result_len);
+
+    for (i = 0; i < set->count; ++i)
+    {
+        int                   marker_group;
+
+        /* the combined expression matches all the patterns at once, only
+         * the fallback below skips the patterns not wanted */
+        if (wanted && !wanted[i])
+        {
+            matched[i] = 0;
+            continue;
+        }
+
+        if (set->count == 1)
+        {
+            if (set->first_groups[i] < 0)
+            {
+                matched[i] = 0;
+                continue;
+            }
+            if (rc < 0 && rc != PCRE_ERROR_NOMATCH)
+                break;
+
+            matched[i] = rc >= 0 && ec_glob_nums_match(set->nums[i], string,
+                    pcre_result, set->first_groups[i]);
+            continue;
+        }
+
+        if (rc < 0)     /* no combined expression, or it failed to run */
+        {
+            matched[i] = (ec_glob(set->patterns[i], string) == 0);
+            continue;
+        }
+
+        if (set->first_groups[i] < 0)
+        {
+            matched[i] = 0;
+            continue;
+        }
+
+        marker_group = set->first_groups[i] + utarray_len(set->nums[i]);
+        matched[i] = marker_group < rc &&
+            pcre_result[2 * marker_group] >= 0 &&
+            ec_glob_nums_match(set->nums[i], string, pcre_result,
+                    set->first_groups[i]);
+    }
+
+    if (pcre_result != pcre_result_stack)
+        free(pcre_result);
+
+    return i < set->count ? -1 : 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_glob_set_free(ec_glob_set *set)
+{
+    int                       i;
+
+    if (!set)
+        return;
+
+    for (i = 0; i < set->count; ++i)
+    {
+        if (set->patterns)
+            free(set->patterns[i]);
+        if (set->nums && set->nums[i])
+            utarray_free(set->nums[i]);
+    }
+    free(set->patterns);
+    free(set->nums);
+    free(set->first_groups);
+    if (set->re_extra)
+        pcre_free_study(set->re_extra);
+    if (set->re)
+        pcre_free(set->re);
+    free(set);
+}
@@ -0,0 +1,465 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The index file is a snapshot of the EditorConfig files in the config file
+ * cache, so that another process can start with a warm cache. A loaded file
+ * is revalidated against its stamp the first time it is used, like any
+ * cached file, thus only the files changed since the index was saved are read
+ * again. The globs are compiled again on load, since the compiled form
+ * depends on the glob engine.
+ *
+ * All the integers are stored in little-endian order:
+ *
+ *   header:    "ECIDX001", u32 file count
+ *   file:      str path, u64 dev, ino, size, mtime, mtime_nsec, ctime,
+ *              ctime_nsec, u32 parse_error, u32 section count
+ *   section:   str name, u32 property count
+ *   property:  str name, str value
+ *   str:       u32 length, then the bytes without the terminating NUL
+ */
+
+#include "global.h"
+
+#ifdef HAVE_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+#include "editorconfig.h"
+#include "misc.h"
+#include "ec_mutex.h"
+#include "ec_config_file.h"
+
+#define EC_INDEX_MAGIC          "ECIDX001"
+#define EC_INDEX_MAGIC_LEN      8
+
+/*
+ * The index file last loaded or saved, and the change count of the config
+ * file cache at that time. Saving the same index again is skipped if no file
+ * has been read since then.
+ */
+static char* last_index_path;
+static unsigned long last_change_count;
+static ec_mutex index_mutex = EC_MUTEX_INITIALIZER;
+
+/* A cursor on the content of an index file */
+typedef struct
+{
+    const unsigned char*    p;
+    const unsigned char*    end;
+} index_reader;
+
+static int read_u32(index_reader* r, unsigned long* value)
+{
+    if (r->end - r->p < 4)
+        return -1;
+
+    *value = (unsigned long)r->p[0] | (unsigned long)r->p[1] << 8 |
+        (unsigned long)r->p[2] << 16 | (unsigned long)r->p[3] << 24;
+    r->p += 4;
+    return 0;
+}
+
+/* Read a u64 into an unsigned long, which keeps the low bits only if it is
+ * 32 bits long. */
+static int read_u64(index_reader* r, unsigned long* value)
+{
+    unsigned long       low;
+    unsigned long       high;
+
+    if (read_u32(r, &low) != 0 || read_u32(r, &high) != 0)
+        return -1;
+
+    *value = low | high << 16 << 16;
+    return 0;
+}
+
+static int read_long(index_reader* r, long* value)
+{
+    unsigned long       u;
+
+    if (read_u64(r, &u) != 0)
+        return -1;
+
+    *value = (long)u;
+    return 0;
+}
+
+/* Read a count of items which take at least item_size bytes each */
+static int read_count(index_reader* r, int* count, size_t item_size)
+{
+    unsigned long       u;
+
+    if (read_u32(r, &u) != 0 || u > (unsigned long)(r->end - r->p) / item_size)
+        return -1;
+
+    *count = (int)u;
+    return 0;
+}
+
+/* Read a str into a newly allocated string */
+static int read_str(index_reader* r, char** str)
+{
+    unsigned long       len;
+
+    if (read_u32(r, &len) != 0 || len > (unsigned long)(r->end - r->p))
+        return -1;
+
+    *str = strndup((const char*)r->p, (size_t)len);
+    if (!*str)
+        return -1;
+    r->p += len;
+    return 0;
+}
+
+/*
+ * Read a file entry into cf, created by ec_config_file_create(). Return 0 on
+ * success, -1 if the entry is truncated or memory runs out. The sections read
+ * so far are left in cf to be freed with it.
+ */
+static int read_file_entry(index_reader* r, ec_config_file* cf)
+{
+    unsigned long       parse_error;
+    int                 section_count;
+    int                 i;
+
+    cf->stamp.exists = 1;
+    if (read_u64(r, &cf->stamp.dev) != 0 ||
+            read_u64(r, &cf->stamp.ino) != 0 ||
+            read_long(r, &cf->stamp.size) != 0 ||
+            read_long(r, &cf->stamp.mtime) != 0 ||
+            read_long(r, &cf->stamp.mtime_nsec) != 0 ||
+            read_long(r, &cf->stamp.ctime) != 0 ||
+            read_long(r, &cf->stamp.ctime_nsec) != 0 ||
+            read_u32(r, &parse_error) != 0)
+        return -1;
+    cf->parse_error = (int)parse_error;
+
+    /* a section takes at least 8 bytes: its name length and property count */
+    if (read_count(r, &section_count, 8) != 0)
+        return -1;
+    if (section_count == 0)
+        return 0;
+    cf->sections = (ec_section*)calloc(section_count, sizeof(ec_section));
+    if (!cf->sections)
+        return -1;
+
+    while (cf->section_count < section_count) {
+        /* count the section first so that it is freed with cf on error */
+        ec_section*     sec = &cf->sections[cf->section_count++];
+        int             property_count;
+
+        if (read_str(r, &sec->name) != 0 ||
+                read_count(r, &property_count, 8) != 0)
+            return -1;
+        if (property_count == 0)
+            continue;
+
+        sec->properties = (ec_property*)calloc(property_count,
+                sizeof(ec_property));
+        if (!sec->properties)
+            return -1;
+        for (i = 0; i < property_count; ++i) {
+            ec_property*    prop = &sec->properties[i];
+
+            if (read_str(r, &prop->name) != 0)
+                return -1;
+            /* count the property now so that its name is freed with cf */
+            ++ sec->property_count;
+            if (read_str(r, &prop->value) != 0)
+                return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Load the index content into the config file cache. Return 0 on success, -1
+ * if it is not a valid index or memory runs out.
+ */
+static int load_index(const unsigned char* content, size_t size)
+{
+    index_reader        r;
+    int                 file_count;
+    int                 i;
+
+    r.p = content;
+    r.end = content + size;
+    if (size < EC_INDEX_MAGIC_LEN ||
+            memcmp(r.p, EC_INDEX_MAGIC, EC_INDEX_MAGIC_LEN) != 0)
+        return -1;
+    r.p += EC_INDEX_MAGIC_LEN;
+
+    /* a file entry takes at least 68 bytes: its path length, stamp, parsing
+     * error and section count */
+    if (read_count(&r, &file_count, 68) != 0)
+        return -1;
+
+    for (i = 0; i < file_count; ++i) {
+        char*               path;
+        ec_config_file*     cf;
+
+        if (read_str(&r, &path) != 0)
+            return -1;
+        cf = ec_config_file_create(path);
+        free(path);
+        if (!cf)
+            return -1;
+
+        if (read_file_entry(&r, cf) != 0) {
+            ec_config_file_free(cf);
+            return -1;
+        }
+        if (ec_config_file_add(cf) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+#ifndef HAVE_MMAP
+/*
+ * Read the whole file at path into a newly allocated buffer. Return NULL if
+ * it can not be read.
+ */
+static unsigned char* read_whole_file(const char* path, size_t* size)
+{
+    FILE*               file;
+    unsigned char*      content = NULL;
+    size_t              capacity = 0;
+
+    file = fopen(path, "rb");
+    if (!file)
+        return NULL;
+
+    *size = 0;
+    for (;;) {
+        if (*size == capacity) {
+            unsigned char*  new_content;
+
+            capacity = capacity ? 2 * capacity : 64 * 1024;
+            new_content = (unsigned char*)realloc(content, capacity);
+            if (!new_content)
+                break;
+            content = new_content;
+        }
+
+        *size += fread(content + *size, 1, capacity - *size, file);
+        if (*size < capacity) {
+            if (ferror(file))
+                break;
+            fclose(file);
+            return content;
+        }
+    }
+
+    free(content);
+    fclose(file);
+    return NULL;
+}
+#endif /* !HAVE_MMAP */
+
+/*
+ * See header file
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_index_load(const char* index_path)
+{
+    size_t              size;
+    int                 ret;
+#ifdef HAVE_MMAP
+    int                 fd;
+    struct stat         sb;
+    void*               content;
+
+    fd = open(index_path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (fstat(fd, &sb) != 0 || sb.st_size <= 0) {
+        close(fd);
+        return -1;
+    }
+    size = (size_t)sb.st_size;
+    content = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (content == MAP_FAILED)
+        return -1;
+
+    ret = load_index((const unsigned char*)content, size);
+    munmap(content, size);
+#else
+    unsigned char*      content;
+
+    content = read_whole_file(index_path, &size);
+    if (!content)
+        return -1;
+
+    ret = load_index(content, size);
+    free(content);
+#endif
+
+    if (ret == 0) {
+        ec_mutex_lock(&index_mutex);
+        free(last_index_path);
+        last_index_path = strdup(index_path);
+        last_change_count = ec_config_file_change_count();
+        ec_mutex_unlock(&index_mutex);
+    }
+
+    return ret;
+}
+
+/* Write an unsigned integer of byte_count bytes */
+static void write_uint(FILE* file, unsigned long value, int byte_count)
+{
+    int                 i;
+
+    for (i = 0; i < byte_count; ++i) {
+        /* shift in two steps, since unsigned long may be 32 bits long */
+        putc((int)(value & 0xff), file);
+        value = value >> 4 >> 4;
+    }
+}
+
+static void write_str(FILE* file, const char* str)
+{
+    size_t              len = strlen(str);
+
+    write_uint(file, (unsigned long)len, 4);
+    fwrite(str, 1, len, file);
+}
+
+/* the second parameter passed to write_file_entry() */
+typedef struct
+{
+    FILE*                   file;
+    unsigned long           file_count;
+} index_writer;
+
+static int write_file_entry(const ec_config_file* cf, void* writer)
+{
+    FILE*               f = ((index_writer*)writer)->file;
+    int                 i;
+    int                 j;
+
+    ++ ((index_writer*)writer)->file_count;
+
+    write_str(f, cf->path);
+    write_uint(f, cf->stamp.dev, 8);
+    write_uint(f, cf->stamp.ino, 8);
+    write_uint(f, (unsigned long)cf->stamp.size, 8);
+    write_uint(f, (unsigned long)cf->stamp.mtime, 8);
+    write_uint(f, (unsigned long)cf->stamp.mtime_nsec, 8);
+    write_uint(f, (unsigned long)cf->stamp.ctime, 8);
+    write_uint(f, (unsigned long)cf->stamp.ctime_nsec, 8);
+    write_uint(f, (unsigned long)cf->parse_error, 4);
+    write_uint(f, (unsigned long)cf->section_count, 4);
+
+    for (i = 0; i < cf->section_count; ++i) {
+        const ec_section*   sec = &cf->sections[i];
+
+        write_str(f, sec->name);
+        write_uint(f, (unsigned long)sec->property_count, 4);
+        for (j = 0; j < sec->property_count; ++j) {
+            write_str(f, sec->properties[j].name);
+            write_str(f, sec->properties[j].value);
+        }
+    }
+
+    return ferror(f) ? -1 : 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_index_save(const char* index_path)
+{
+    unsigned long       change_count = ec_config_file_change_count();
+    index_writer        writer;
+    char*               tmp_path;
+    int                 ret;
+
+    ec_mutex_lock(&index_mutex);
+    ret = last_index_path && !strcmp(last_index_path, index_path) &&
+        last_change_count == change_count;
+    ec_mutex_unlock(&index_mutex);
+    if (ret)    /* nothing has changed since the index was loaded or saved */
+        return 0;
+
+    /* write a temporary file which replaces the index at once, so that a
+     * concurrent reader never sees a partial index */
+    tmp_path = (char*)malloc(strlen(index_path) + sizeof(".tmp"));
+    if (!tmp_path)
+        return -1;
+    strcpy(tmp_path, index_path);
+    strcat(tmp_path, ".tmp");
+
+    writer.file = fopen(tmp_path, "wb");
+    if (!writer.file) {
+        free(tmp_path);
+        return -1;
+    }
+
+    /* the file count is known once the files are written */
+    writer.file_count = 0;
+    fwrite(EC_INDEX_MAGIC, 1, EC_INDEX_MAGIC_LEN, writer.file);
+    write_uint(writer.file, 0, 4);
+    ret = ec_config_file_foreach(write_file_entry, &writer);
+    if (ret == 0 && fseek(writer.file, EC_INDEX_MAGIC_LEN, SEEK_SET) == 0)
+        write_uint(writer.file, writer.file_count, 4);
+    else
+        ret = -1;
+
+    if (ferror(writer.file))
+        ret = -1;
+    if (fclose(writer.file) != 0)
+        ret = -1;
+#ifdef WIN32
+    /* rename() does not replace an existing file on Windows */
+    if (ret == 0)
+        remove(index_path);
+#endif
+    if (ret == 0 && rename(tmp_path, index_path) != 0)
+        ret = -1;
+    if (ret != 0)
+        remove(tmp_path);
+    free(tmp_path);
+
+    if (ret == 0) {
+        ec_mutex_lock(&index_mutex);
+        free(last_index_path);
+        last_index_path = strdup(index_path);
+        last_change_count = change_count;
+        ec_mutex_unlock(&index_mutex);
+    }
+
+    return ret;
+}
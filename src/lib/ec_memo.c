@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "global.h"
+
+#include "misc.h"
+#include "ec_memo.h"
+
+/* Count of buckets of the hash table of a memo */
+#define EC_MEMO_BUCKETS     64
+
+struct ec_memo_entry
+{
+    char*                           key;
+    unsigned int                    hash;
+    struct ec_memo_entry*           next;
+    editorconfig_name_value*        name_values;
+    int                             name_value_count;
+};
+
+/* Release the files of memo and forget its results */
+static void ec_memo_clear(ec_memo* memo)
+{
+    int             i;
+
+    for (i = 0; i < memo->file_count; ++i)
+        ec_config_file_release(memo->files[i]);
+    ec_arena_reset(&memo->arena);
+    memo->dir = NULL;
+    memo->files = NULL;
+    memo->file_count = 0;
+    memo->buckets = NULL;
+    memo->properties = NULL;
+    memo->property_count = 0;
+    memo->is_usable = 0;
+}
+
+/*
+ * Whether the results of memo are those of the directory dir of length
+ * dir_len, to which the count files of files apply, for the parses of eh
+ */
+static _Bool ec_memo_is_for(const ec_memo* memo, const char* dir,
+        size_t dir_len, ec_config_file* const* files, int count,
+        const struct editorconfig_handle* eh)
+{
+    int             i;
+
+    if (!memo->dir || memo->file_count != count ||
+            strlen(memo->dir) != dir_len || memcmp(memo->dir, dir, dir_len) ||
+            memo->ver.major != eh->ver.major ||
+            memo->ver.minor != eh->ver.minor ||
+            memo->ver.patch != eh->ver.patch ||
+            !memo->properties != !eh->properties ||
+            memo->property_count != eh->property_count)
+        return 0;
+
+    for (i = 0; i < count; ++i)
+        if (memo->files[i] != files[i])
+            return 0;
+
+    for (i = 0; i < eh->property_count; ++i)
+        if (memo->properties[i].is_dependency !=
+                eh->properties[i].is_dependency ||
+                strcmp(memo->properties[i].name, eh->properties[i].name))
+            return 0;
+
+    return 1;
+}
+
+/*
+ * Empty memo and set it up for the directory dir of length dir_len, to which
+ * the count files of files apply, for the parses of eh. Return 0 on success,
+ * -1 if memory runs out.
+ */
+static int ec_memo_reset(ec_memo* memo, const char* dir, size_t dir_len,
+        ec_config_file* const* files, int count,
+        const struct editorconfig_handle* eh)
+{
+    size_t          key_size = 1;
+    int             i;
+
+    ec_memo_clear(memo);
+
+    memo->dir = ec_arena_strndup(&memo->arena, dir, dir_len);
+    memo->files = (ec_config_file**)ec_arena_alloc(&memo->arena,
+            (count ? count : 1) * sizeof(ec_config_file*));
+    memo->buckets = (ec_memo_entry**)ec_arena_alloc(&memo->arena,
+            EC_MEMO_BUCKETS * sizeof(ec_memo_entry*));
+    if (!memo->dir || !memo->files || !memo->buckets) {
+        memo->dir = NULL;
+        return -1;
+    }
+    memset(memo->buckets, 0, EC_MEMO_BUCKETS * sizeof(ec_memo_entry*));
+    memo->ver = eh->ver;
+
+    if (eh->properties) {
+        memo->properties = (ec_wanted_property*)ec_arena_alloc(&memo->arena,
+                (eh->property_count ? eh->property_count : 1) *
+                sizeof(ec_wanted_property));
+        if (!memo->properties) {
+            memo->dir = NULL;
+            return -1;
+        }
+        for (i = 0; i < eh->property_count; ++i) {
+            memo->properties[i] = eh->properties[i];
+            memo->properties[i].name = ec_arena_strdup(&memo->arena,
+                    eh->properties[i].name);
+            if (!memo->properties[i].name) {
+                memo->dir = NULL;
+                return -1;
+            }
+        }
+        memo->property_count = eh->property_count;
+    }
+
+    /* the files are held, so that another file is never at the same address
+     * while the memo is in use */
+    memo->is_usable = 1;
+    for (i = 0; i < count; ++i) {
+        ec_config_file_retain(files[i]);
+        memo->files[i] = files[i];
+        if (files[i]->parse_error != 0 || files[i]->names_opaque)
+            memo->is_usable = 0;
+        key_size += files[i]->name_test_count;
+    }
+    memo->file_count = count;
+
+    if (key_size > memo->key_size) {
+        char*           key = (char*)realloc(memo->key, key_size);
+
+        if (!key) {
+            memo->is_usable = 0;
+            return -1;
+        }
+        memo->key = key;
+        memo->key_size = key_size;
+    }
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+int ec_memo_find(ec_memo* memo, const char* full_filename,
+        ec_config_file* const* files, int count,
+        const struct editorconfig_handle* eh,
+        const editorconfig_name_value** name_values, int* name_value_count)
+{
+    const char*     name = strrchr(full_filename, '/');
+    size_t          dir_len;
+    size_t          name_len;
+    char*           k;
+    ec_memo_entry*  entry;
+    int             i;
+    int             j;
+
+    if (!name)
+        return -1;
+    dir_len = name - full_filename;
+    name_len = strlen(++name);
+
+    if (!ec_memo_is_for(memo, full_filename, dir_len, files, count, eh) &&
+            ec_memo_reset(memo, full_filename, dir_len, files, count,
+                eh) != 0)
+        return -1;
+    if (!memo->is_usable)
+        return -1;
+
+    k = memo->key;
+    for (i = 0; i < count; ++i) {
+        for (j = 0; j < files[i]->name_test_count; ++j) {
+            const ec_name_test*     test = &files[i]->name_tests[j];
+
+            if (test->is_suffix)
+                *k++ = (test->len <= name_len && !memcmp(
+                            name + name_len - test->len, test->literal,
+                            test->len)) ? '1' : '0';
+            else
+                *k++ = (test->len == name_len &&
+                        !memcmp(name, test->literal, name_len)) ? '1' : '0';
+        }
+    }
+    *k = '\0';
+    memo->key_hash = ec_str_hash(memo->key);
+
+    for (entry = memo->buckets[memo->key_hash % EC_MEMO_BUCKETS]; entry;
+            entry = entry->next) {
+        if (entry->hash == memo->key_hash && !strcmp(entry->key, memo->key)) {
+            *name_values = entry->name_values;
+            *name_value_count = entry->name_value_count;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+int ec_memo_add(ec_memo* memo, const editorconfig_name_value* name_values,
+        int name_value_count)
+{
+    ec_memo_entry*  entry;
+    int             i;
+
+    entry = (ec_memo_entry*)ec_arena_alloc(&memo->arena,
+            sizeof(ec_memo_entry));
+    if (!entry)
+        return -1;
+    entry->key = ec_arena_strdup(&memo->arena, memo->key);
+    entry->name_values = (editorconfig_name_value*)ec_arena_alloc(
+            &memo->arena, (name_value_count ? name_value_count : 1) *
+            sizeof(editorconfig_name_value));
+    if (!entry->key || !entry->name_values)
+        return -1;
+    for (i = 0; i < name_value_count; ++i) {
+        entry->name_values[i].name = ec_arena_strdup(&memo->arena,
+                name_values[i].name);
+        entry->name_values[i].value = ec_arena_strdup(&memo->arena,
+                name_values[i].value);
+        if (!entry->name_values[i].name || !entry->name_values[i].value)
+            return -1;
+    }
+    entry->name_value_count = name_value_count;
+    entry->hash = memo->key_hash;
+
+    entry->next = memo->buckets[entry->hash % EC_MEMO_BUCKETS];
+    memo->buckets[entry->hash % EC_MEMO_BUCKETS] = entry;
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_LOCAL
+void ec_memo_free(ec_memo* memo)
+{
+    ec_memo_clear(memo);
+    ec_arena_free(&memo->arena);
+    free(memo->key);
+    memo->key = NULL;
+    memo->key_size = 0;
+}
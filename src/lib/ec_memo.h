@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EC_MEMO_H__
+#define __EC_MEMO_H__
+
+#include "global.h"
+#include "editorconfig.h"
+#include "editorconfig_handle.h"
+#include "ec_arena.h"
+#include "ec_config_file.h"
+
+typedef struct ec_memo_entry ec_memo_entry;
+
+/*
+ * The results of the files of a directory, memoized by the results of the
+ * tests made on their names by the EditorConfig files applying to them: two
+ * files with the same results are matched by the same sections, thus get the
+ * same properties. A memo is initialized by filling it with zeros, and is
+ * emptied whenever it is used for another directory or other EditorConfig
+ * files.
+ */
+typedef struct ec_memo
+{
+    /* the memory of the results, of dir and of the entries */
+    ec_arena                        arena;
+    /* what the results depend on besides the names of the files: the
+     * directory of the files, the EditorConfig files, held by the memo, and
+     * the version and properties of the handle */
+    char*                           dir;
+    ec_config_file**                files;
+    int                             file_count;
+    struct editorconfig_version     ver;
+    ec_wanted_property*             properties;
+    int                             property_count;
+    /* whether the names of the files only matter through their tests */
+    _Bool                           is_usable;
+    ec_memo_entry**                 buckets;
+    /* the key of the last name looked up, one character per test */
+    char*                           key;
+    size_t                          key_size;
+    unsigned int                    key_hash;
+} ec_memo;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Look up the result of full_filename, to whose directory the count
+ * EditorConfig files of files apply, for the parses of eh. Return 1 and set
+ * name_values and name_value_count if found, 0 if not found, -1 if the result
+ * of full_filename cannot be memoized or memory runs out.
+ */
+EDITORCONFIG_LOCAL
+int ec_memo_find(ec_memo* memo, const char* full_filename,
+        ec_config_file* const* files, int count,
+        const struct editorconfig_handle* eh,
+        const editorconfig_name_value** name_values, int* name_value_count);
+
+/*
+ * Memoize the result of the last name not found by ec_memo_find(). Return 0
+ * on success, -1 if memory runs out.
+ */
+EDITORCONFIG_LOCAL
+int ec_memo_add(ec_memo* memo, const editorconfig_name_value* name_values,
+        int name_value_count);
+
+/* Release the memory and the EditorConfig files of memo */
+EDITORCONFIG_LOCAL
+void ec_memo_free(ec_memo* memo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !__EC_MEMO_H__ */
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EC_MUTEX_H__
+#define __EC_MUTEX_H__
+
+#include "global.h"
+
+/*
+ * A statically initializable mutex used to guard the process-wide caches of
+ * the library.
+ */
+#if defined(WIN32)
+# include <windows.h>
+typedef SRWLOCK ec_mutex;
+# define EC_MUTEX_INITIALIZER       SRWLOCK_INIT
+# define ec_mutex_lock(m)           AcquireSRWLockExclusive(m)
+# define ec_mutex_unlock(m)         ReleaseSRWLockExclusive(m)
+#elif defined(UNIX)
+# include <pthread.h>
+typedef pthread_mutex_t ec_mutex;
+# define EC_MUTEX_INITIALIZER       PTHREAD_MUTEX_INITIALIZER
+# define ec_mutex_lock(m)           pthread_mutex_lock(m)
+# define ec_mutex_unlock(m)         pthread_mutex_unlock(m)
+#else
+# error "Either UNIX or WIN32 must be defined."
+#endif
+
+#endif /* !__EC_MUTEX_H__ */
@@ -0,0 +1,534 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The watcher of the EditorConfig files used by the resolution walk. Every
+ * directory visited by the walk is watched with inotify, since an
+ * EditorConfig file can appear in any of them, and so is every existing
+ * EditorConfig file. The events concerning the EditorConfig files are turned
+ * into changes by editorconfig_watch_poll(), each one increasing the
+ * generation and reported to the callback with the directory concerned.
+ */
+
+#include "global.h"
+
+#ifdef HAVE_INOTIFY
+# include <errno.h>
+# include <sys/inotify.h>
+# include <unistd.h>
+#endif
+
+#include "editorconfig.h"
+#include "misc.h"
+#include "ec_mutex.h"
+#include "ec_watch.h"
+
+#ifdef HAVE_INOTIFY
+
+#define EC_WATCH_DIR_MASK   (IN_CREATE | IN_DELETE | IN_MODIFY | \
+        IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | \
+        IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+#define EC_WATCH_FILE_MASK  (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | \
+        IN_DELETE_SELF | IN_MOVE_SELF)
+
+/* A watched directory or EditorConfig file */
+typedef struct ec_watch_entry
+{
+    char*                   path;
+    unsigned int            hash;
+    int                     wd;
+    _Bool                   is_file;
+    struct ec_watch_entry*  path_next;
+    struct ec_watch_entry*  wd_next;
+} ec_watch_entry;
+
+/* The watched entries, found by path and by watch descriptor */
+static struct
+{
+    _Bool                   started;
+    int                     fd;
+    ec_watch_entry**        path_buckets;
+    ec_watch_entry**        wd_buckets;
+    int                     bucket_count;
+    int                     count;
+    /* the EditorConfig file names looked up in the watched directories */
+    char**                  conf_file_names;
+    int                     conf_file_name_count;
+    /* set if a watch could not be added, so that any file may change
+     * unnoticed */
+    _Bool                   lost;
+} watcher;
+
+#endif /* HAVE_INOTIFY */
+
+static unsigned long watch_generation;
+static editorconfig_watch_callback watch_callback;
+static void* watch_callback_user_data;
+static ec_mutex watch_mutex = EC_MUTEX_INITIALIZER;
+
+#ifdef HAVE_INOTIFY
+
+/* watch_mutex must be held by all the functions below */
+
+static ec_watch_entry* watch_find_path(const char* path, unsigned int hash)
+{
+    ec_watch_entry*         entry;
+
+    if (watcher.bucket_count == 0)
+        return NULL;
+
+    for (entry = watcher.path_buckets[hash % watcher.bucket_count]; entry;
+            entry = entry->path_next)
+        if (entry->hash == hash && !strcmp(entry->path, path))
+            return entry;
+
+    return NULL;
+}
+
+static ec_watch_entry* watch_find_wd(int wd)
+{
+    ec_watch_entry*         entry;
+
+    if (watcher.bucket_count == 0)
+        return NULL;
+
+    for (entry = watcher.wd_buckets[(unsigned int) wd % watcher.bucket_count];
+            entry; entry = entry->wd_next)
+        if (entry->wd == wd)
+            return entry;
+
+    return NULL;
+}
+
+/* Add entry to the tables. Return 0 on success, -1 if memory runs out. */
+static int watch_insert(ec_watch_entry* entry)
+{
+    /* grow the tables to keep the chains short */
+    if (watcher.count >= watcher.bucket_count) {
+        int                 bucket_count = watcher.bucket_count ?
+            2 * watcher.bucket_count : 256;
+        ec_watch_entry**    path_buckets;
+        ec_watch_entry**    wd_buckets;
+        int                 i;
+
+        path_buckets = (ec_watch_entry**) calloc(bucket_count,
+                sizeof(ec_watch_entry*));
+        wd_buckets = (ec_watch_entry**) calloc(bucket_count,
+                sizeof(ec_watch_entry*));
+        if (!path_buckets || !wd_buckets) {
+            free(path_buckets);
+            free(wd_buckets);
+            return -1;
+        }
+        for (i = 0; i < watcher.bucket_count; ++i) {
+            ec_watch_entry*     moved;
+
+            while ((moved = watcher.path_buckets[i])) {
+                watcher.path_buckets[i] = moved->path_next;
+                moved->path_next = path_buckets[moved->hash % bucket_count];
+                path_buckets[moved->hash % bucket_count] = moved;
+            }
+            while ((moved = watcher.wd_buckets[i])) {
+                watcher.wd_buckets[i] = moved->wd_next;
+                moved->wd_next =
+                    wd_buckets[(unsigned int) moved->wd % bucket_count];
+                wd_buckets[(unsigned int) moved->wd % bucket_count] = moved;
+            }
+        }
+        free(watcher.path_buckets);
+        free(watcher.wd_buckets);
+        watcher.path_buckets = path_buckets;
+        watcher.wd_buckets = wd_buckets;
+        watcher.bucket_count = bucket_count;
+    }
+
+    entry->path_next = watcher.path_buckets[entry->hash %
+        watcher.bucket_count];
+    watcher.path_buckets[entry->hash % watcher.bucket_count] = entry;
+    entry->wd_next = watcher.wd_buckets[(unsigned int) entry->wd %
+        watcher.bucket_count];
+    watcher.wd_buckets[(unsigned int) entry->wd % watcher.bucket_count] =
+        entry;
+    ++ watcher.count;
+
+    return 0;
+}
+
+/* Remove entry from the tables and free it */
+static void watch_remove(ec_watch_entry* entry)
+{
+    ec_watch_entry**        pp;
+
+    for (pp = &watcher.path_buckets[entry->hash % watcher.bucket_count];
+            *pp != entry; pp = &(*pp)->path_next)
+        ;
+    *pp = entry->path_next;
+    for (pp = &watcher.wd_buckets[(unsigned int) entry->wd %
+            watcher.bucket_count]; *pp != entry; pp = &(*pp)->wd_next)
+        ;
+    *pp = entry->wd_next;
+    -- watcher.count;
+
+    free(entry->path);
+    free(entry);
+}
+
+/* Watch path, a directory or an EditorConfig file, if it is not yet */
+static void watch_add(const char* path, _Bool is_file)
+{
+    unsigned int            hash = ec_str_hash(path);
+    ec_watch_entry*         entry;
+    int                     wd;
+
+    if (watch_find_path(path, hash))
+        return;
+
+    wd = inotify_add_watch(watcher.fd, path,
+            is_file ? EC_WATCH_FILE_MASK : EC_WATCH_DIR_MASK);
+    if (wd < 0) {
+        /* a missing directory or file is seen when it is created, by the
+         * watch of its parent directory */
+        if (errno != ENOENT && errno != ENOTDIR)
+            watcher.lost = 1;
+        return;
+    }
+
+    /* the same directory or file is watched through another path already */
+    if (watch_find_wd(wd))
+        return;
+
+    entry = (ec_watch_entry*) calloc(1, sizeof(ec_watch_entry));
+    if (entry) {
+        entry->path = strdup(path);
+        entry->hash = hash;
+        entry->wd = wd;
+        entry->is_file = is_file;
+    }
+    if (!entry || !entry->path || watch_insert(entry) != 0) {
+        if (entry)
+            free(entry->path);
+        free(entry);
+        inotify_rm_watch(watcher.fd, wd);
+        watcher.lost = 1;
+    }
+}
+
+static _Bool is_conf_file_name(const char* name)
+{
+    int                     i;
+
+    for (i = 0; i < watcher.conf_file_name_count; ++i)
+        if (!strcmp(watcher.conf_file_names[i], name))
+            return 1;
+
+    return 0;
+}
+
+static void add_conf_file_name(const char* conf_file_name)
+{
+    char**                  names;
+
+    if (is_conf_file_name(conf_file_name))
+        return;
+
+    names = (char**) realloc(watcher.conf_file_names,
+            (watcher.conf_file_name_count + 1) * sizeof(char*));
+    if (!names || !(names[watcher.conf_file_name_count] =
+                strdup(conf_file_name))) {
+        if (names)
+            watcher.conf_file_names = names;
+        watcher.lost = 1;
+        return;
+    }
+    watcher.conf_file_names = names;
+    ++ watcher.conf_file_name_count;
+}
+
+/* Remove all the watches */
+static void watch_clear(void)
+{
+    int                     i;
+
+    for (i = 0; i < watcher.bucket_count; ++i) {
+        while (watcher.path_buckets[i]) {
+            ec_watch_entry*     entry = watcher.path_buckets[i];
+
+            watcher.path_buckets[i] = entry->path_next;
+            free(entry->path);
+            free(entry);
+        }
+    }
+    free(watcher.path_buckets);
+    free(watcher.wd_buckets);
+    for (i = 0; i < watcher.conf_file_name_count; ++i)
+        free(watcher.conf_file_names[i]);
+    free(watcher.conf_file_names);
+
+    memset(&watcher, 0, sizeof(watcher));
+    watcher.fd = -1;
+}
+
+/* The changes found in the pending events, as directories or NULL */
+typedef struct
+{
+    char**                  dirs;
+    int                     count;
+    _Bool                   failed;
+} change_list;
+
+/*
+ * Add the directory of entry to changes, or NULL if entry is NULL. A file
+ * changes its directory.
+ */
+static void change_list_add(change_list* changes, const ec_watch_entry* entry)
+{
+    char*                   dir = NULL;
+    char**                  dirs;
+    int                     i;
+
+    if (entry) {
+        size_t              len = strlen(entry->path);
+
+        if (entry->is_file) {
+            const char*     slash = strrchr(entry->path, '/');
+
+            len = slash && slash != entry->path ? slash - entry->path : 1;
+        }
+        dir = strndup(entry->path, len);
+        if (!dir) {
+            changes->failed = 1;
+            return;
+        }
+    }
+
+    /* report each directory once */
+    for (i = 0; i < changes->count; ++i) {
+        if (dir == changes->dirs[i] || (dir && changes->dirs[i] &&
+                    !strcmp(dir, changes->dirs[i]))) {
+            free(dir);
+            return;
+        }
+    }
+
+    dirs = (char**) realloc(changes->dirs,
+            (changes->count + 1) * sizeof(char*));
+    if (!dirs) {
+        free(dir);
+        changes->failed = 1;
+        return;
+    }
+    changes->dirs = dirs;
+    changes->dirs[changes->count++] = dir;
+}
+
+/* Turn the pending events into changes */
+static void watch_read_events(change_list* changes)
+{
+    /* aligned for the events */
+    union
+    {
+        struct inotify_event    event;
+        char                    data[4096];
+    }                       events;
+    ssize_t                 n;
+
+    while ((n = read(watcher.fd, events.data, sizeof(events.data))) > 0) {
+        char*               p;
+
+        for (p = events.data; p < events.data + n;
+                p += sizeof(struct inotify_event) +
+                ((struct inotify_event*) p)->len) {
+            const struct inotify_event* event = (struct inotify_event*) p;
+            ec_watch_entry*             entry;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                change_list_add(changes, NULL);
+                continue;
+            }
+
+            entry = watch_find_wd(event->wd);
+            if (!entry)
+                continue;
+
+            /* the directory or file is gone: it is watched again through
+             * its path if the walk visits it again */
+            if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF |
+                        IN_UNMOUNT)) {
+                change_list_add(changes, entry);
+                if (!(event->mask & IN_IGNORED))
+                    inotify_rm_watch(watcher.fd, entry->wd);
+                watch_remove(entry);
+            } else if (entry->is_file) {
+                change_list_add(changes, entry);
+            } else if (event->len > 0 && is_conf_file_name(event->name)) {
+                change_list_add(changes, entry);
+            } else if ((event->mask & IN_ISDIR) &&
+                    (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                /* a directory which was missing when it was visited */
+                change_list_add(changes, entry);
+            }
+        }
+    }
+
+    if (watcher.lost || changes->failed) {
+        watcher.lost = 0;
+        change_list_add(changes, NULL);
+    }
+}
+
+#endif /* HAVE_INOTIFY */
+
+EDITORCONFIG_LOCAL
+void ec_watch_dir(const char* dir, const char* conf_file_name)
+{
+#ifdef HAVE_INOTIFY
+    ec_mutex_lock(&watch_mutex);
+    if (watcher.started) {
+        add_conf_file_name(conf_file_name);
+        watch_add(*dir ? dir : "/", 0);
+    }
+    ec_mutex_unlock(&watch_mutex);
+#else
+    (void) dir;
+    (void) conf_file_name;
+#endif
+}
+
+EDITORCONFIG_LOCAL
+void ec_watch_file(const char* path)
+{
+#ifdef HAVE_INOTIFY
+    ec_mutex_lock(&watch_mutex);
+    if (watcher.started)
+        watch_add(path, 1);
+    ec_mutex_unlock(&watch_mutex);
+#else
+    (void) path;
+#endif
+}
+
+/*
+ * See the header editorconfig.h for the documentation of the functions below
+ */
+
+EDITORCONFIG_EXPORT
+int editorconfig_watch_start(void)
+{
+#ifdef HAVE_INOTIFY
+    int                     ret = 0;
+
+    ec_mutex_lock(&watch_mutex);
+    if (!watcher.started) {
+        watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (watcher.fd >= 0)
+            watcher.started = 1;
+        else
+            ret = -1;
+    }
+    ec_mutex_unlock(&watch_mutex);
+
+    return ret;
+#else
+    return -1;
+#endif
+}
+
+EDITORCONFIG_EXPORT
+void editorconfig_watch_stop(void)
+{
+#ifdef HAVE_INOTIFY
+    ec_mutex_lock(&watch_mutex);
+    if (watcher.started) {
+        close(watcher.fd);
+        watch_clear();
+    }
+    ec_mutex_unlock(&watch_mutex);
+#endif
+}
+
+EDITORCONFIG_EXPORT
+int editorconfig_watch_get_fd(void)
+{
+#ifdef HAVE_INOTIFY
+    int                     fd;
+
+    ec_mutex_lock(&watch_mutex);
+    fd = watcher.started ? watcher.fd : -1;
+    ec_mutex_unlock(&watch_mutex);
+
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+EDITORCONFIG_EXPORT
+void editorconfig_watch_set_callback(editorconfig_watch_callback callback,
+        void* user_data)
+{
+    ec_mutex_lock(&watch_mutex);
+    watch_callback = callback;
+    watch_callback_user_data = user_data;
+    ec_mutex_unlock(&watch_mutex);
+}
+
+EDITORCONFIG_EXPORT
+unsigned long editorconfig_watch_poll(void)
+{
+    unsigned long           generation;
+#ifdef HAVE_INOTIFY
+    change_list             changes;
+    editorconfig_watch_callback callback;
+    void*                   user_data;
+    int                     i;
+
+    memset(&changes, 0, sizeof(changes));
+
+    ec_mutex_lock(&watch_mutex);
+    if (watcher.started)
+        watch_read_events(&changes);
+    generation = watch_generation + changes.count;
+    watch_generation = generation;
+    callback = watch_callback;
+    user_data = watch_callback_user_data;
+    ec_mutex_unlock(&watch_mutex);
+
+    /* the callback may use the library, so it is called without the lock */
+    for (i = 0; i < changes.count; ++i) {
+        if (callback)
+            callback(changes.dirs[i],
+                    generation - changes.count + i + 1, user_data);
+        free(changes.dirs[i]);
+    }
+    free(changes.dirs);
+#else
+    ec_mutex_lock(&watch_mutex);
+    generation = watch_generation;
+    ec_mutex_unlock(&watch_mutex);
+#endif
+
+    return generation;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2014 EditorConfig Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __EC_WATCH_H__
+#define __EC_WATCH_H__
+
+#include "global.h"
+
+/*
+ * Hooks of the watcher of EditorConfig files, called by the resolution walk.
+ * They do nothing unless editorconfig_watch_start() has been called.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Watch dir, where an EditorConfig file named conf_file_name may appear. dir
+ * is "" for the root directory. Called before the EditorConfig file of dir is
+ * read, so that no change is missed.
+ */
+EDITORCONFIG_LOCAL
+void ec_watch_dir(const char* dir, const char* conf_file_name);
+
+/*
+ * Watch the existing EditorConfig file at path, so that the changes of the
+ * target of a symbolic link are seen too.
+ */
+EDITORCONFIG_LOCAL
+void ec_watch_file(const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !__EC_WATCH_H__ */
@@ -25,10 +25,26 @@
 */
 
 #include "global.h"
+
+#if defined(HAVE_OPENAT) && defined(HAVE_FDOPENDIR)
+# define EC_TREE_WALK
+# include <dirent.h>
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <unistd.h>
+# ifdef CMAKE_USE_PTHREADS_INIT
+#  include <pthread.h>
+# endif
+#endif
+
 #include "editorconfig.h"
 #include "misc.h"
 #include "ini.h"
+#include "ec_arena.h"
+#include "ec_config_file.h"
 #include "ec_glob.h"
+#include "ec_memo.h"
+#include "ec_watch.h"
 
 /* could be used to fast locate these properties in an
  * array_editorconfig_name_value */
@@ -39,58 +55,149 @@ typedef struct
     const editorconfig_name_value*        tab_width;
 } special_property_name_value_pointers;
 
+/* A slot of the hash table of array_editorconfig_name_value */
+typedef struct
+{
+    unsigned int                            name_hash;
+    /* position of the name value in the array plus one, 0 if empty */
+    int                                     index;
+} name_value_slot;
+
 typedef struct
 {
+    /* the memory of name_values, slots and the names and values */
+    ec_arena*                               arena;
     editorconfig_name_value*                name_values;
     int                                     current_value_count;
     int                                     max_value_count;
+    /* open addressing hash table of name_values, indexed by the name hash.
+     * slot_count is a power of 2. */
+    name_value_slot*                        slots;
+    int                                     slot_count;
     special_property_name_value_pointers    spnvp;
 } array_editorconfig_name_value;
 
 typedef struct
 {
     char*                           full_filename;
-    char*                           editorconfig_file_dir;
     array_editorconfig_name_value   array_name_value;
+    /* the properties resolved, NULL for all of them */
+    const ec_wanted_property*       properties;
+    int                             property_count;
 } handler_first_param;
 
+/* The properties known by this library */
+typedef enum
+{
+    SPECIAL_NONE,
+    SPECIAL_INDENT_STYLE,
+    SPECIAL_INDENT_SIZE,
+    SPECIAL_TAB_WIDTH
+} special_property;
+
+typedef struct
+{
+    const char*         name;
+    /* whether the value is case insensitive, and lowercased */
+    _Bool               lower_value;
+    special_property    special;
+} known_property;
+
+/* Perfect hash of the known property names, see find_known_property() */
+#define KNOWN_PROPERTY_HASH(name, len) \
+    ((3 * (len) + (unsigned char)(name)[0]) & 15)
+
+static const known_property known_properties[16] =
+{
+    { NULL,                         0, SPECIAL_NONE },
+    { NULL,                         0, SPECIAL_NONE },
+    { NULL,                         0, SPECIAL_NONE },
+    { NULL,                         0, SPECIAL_NONE },
+    { NULL,                         0, SPECIAL_NONE },
+    { "insert_final_newline",       1, SPECIAL_NONE },          /* 5 */
+    { "end_of_line",                1, SPECIAL_NONE },          /* 6 */
+    { NULL,                         0, SPECIAL_NONE },
+    { "charset",                    1, SPECIAL_NONE },          /* 8 */
+    { NULL,                         0, SPECIAL_NONE },
+    { "indent_size",                1, SPECIAL_INDENT_SIZE },   /* 10 */
+    { NULL,                         0, SPECIAL_NONE },
+    { "trim_trailing_whitespace",   1, SPECIAL_NONE },          /* 12 */
+    { "indent_style",               1, SPECIAL_INDENT_STYLE },  /* 13 */
+    { NULL,                         0, SPECIAL_NONE },
+    { "tab_width",                  0, SPECIAL_TAB_WIDTH }      /* 15 */
+};
+
+/*
+ * Find the known property of a lowercase name. Return NULL if the name is not
+ * known.
+ */
+static const known_property* find_known_property(const char* name)
+{
+    size_t                  len = strlen(name);
+    const known_property*   kp;
+
+    if (len == 0)
+        return NULL;
+
+    kp = &known_properties[KNOWN_PROPERTY_HASH(name, len)];
+    return kp->name && !strcmp(kp->name, name) ? kp : NULL;
+}
+
 /*
  * Set the special pointers for a name
  */
 static void set_special_property_name_value_pointers(
-        const editorconfig_name_value* nv,
+        const editorconfig_name_value* nv, const known_property* kp,
         special_property_name_value_pointers* spnvp)
 {
+    if (!kp)
+        return;
+
     /* set speical pointers */
-    if (!strcmp(nv->name, "indent_style"))
+    switch (kp->special) {
+    case SPECIAL_INDENT_STYLE:
         spnvp->indent_style = nv;
-    else if (!strcmp(nv->name, "indent_size"))
+        break;
+    case SPECIAL_INDENT_SIZE:
         spnvp->indent_size = nv;
-    else if (!strcmp(nv->name, "tab_width"))
+        break;
+    case SPECIAL_TAB_WIDTH:
         spnvp->tab_width = nv;
+        break;
+    case SPECIAL_NONE:
+        break;
+    }
 }
 
 /*
- * Set the name and value of a editorconfig_name_value structure
+ * Set the name and value of a editorconfig_name_value structure, copying them
+ * into arena. Return 0 on success, -1 if memory runs out.
  */
-static void set_name_value(editorconfig_name_value* nv, const char* name,
-        const char* value, special_property_name_value_pointers* spnvp)
+static int set_name_value(ec_arena* arena, editorconfig_name_value* nv,
+        const char* name, const char* value,
+        special_property_name_value_pointers* spnvp)
 {
-    if (name)
-        nv->name = strdup(name);
-    if (value)
-        nv->value = strdup(value);
-    /* lowercase the value when the name is one of the following */
-    if (!strcmp(nv->name, "end_of_line") ||
-            !strcmp(nv->name, "indent_style") ||
-            !strcmp(nv->name, "indent_size") ||
-            !strcmp(nv->name, "insert_final_newline") ||
-            !strcmp(nv->name, "trim_trailing_whitespace") ||
-            !strcmp(nv->name, "charset"))
+    const known_property*   kp;
+
+    if (name) {
+        nv->name = ec_arena_strdup(arena, name);
+        if (!nv->name)
+            return -1;
+    }
+    nv->value = ec_arena_strdup(arena, value);
+    if (!nv->value)
+        return -1;
+
+    kp = find_known_property(nv->name);
+    /* lowercase the value when the name is one of the known properties
+     * whose value is case insensitive */
+    if (kp && kp->lower_value)
         strlwr(nv->value);
 
     /* set speical pointers */
-    set_special_property_name_value_pointers(nv, spnvp);
+    set_special_property_name_value_pointers(nv, kp, spnvp);
+
+    return 0;
 }
 
 /*
@@ -102,46 +209,77 @@ static void reset_special_property_name_value_pointers(
     int         i;
     
     for (i = 0; i < aenv->current_value_count; ++ i)
-        set_special_property_name_value_pointers(
-                &aenv->name_values[i], &aenv->spnvp);
+        set_special_property_name_value_pointers(&aenv->name_values[i],
+                find_known_property(aenv->name_values[i].name),
+                &aenv->spnvp);
 }
 
 /*
- * Find the editorconfig_name_value from name in a editorconfig_name_value
- * array.
+ * initialize array_editorconfig_name_value, whose memory is allocated from
+ * arena
  */
-static int find_name_value_from_name(const editorconfig_name_value* env,
-        int count, const char* name)
+static void array_editorconfig_name_value_init(
+        array_editorconfig_name_value* aenv, ec_arena* arena)
 {
-    int         i;
-
-    for (i = 0; i < count; ++i)
-        if (!strcmp(env[i].name, name)) /* found */
-            return i;
-
-    return -1;
+    memset(aenv, 0, sizeof(array_editorconfig_name_value));
+    aenv->arena = arena;
 }
 
-/* initialize array_editorconfig_name_value */
-static void array_editorconfig_name_value_init(
+/*
+ * Double the size of the hash table of aenv. Return 0 on success, -1 if
+ * memory runs out.
+ */
+static int array_editorconfig_name_value_grow_slots(
         array_editorconfig_name_value* aenv)
 {
-    memset(aenv, 0, sizeof(array_editorconfig_name_value));
+#define SLOT_COUNT_INITIAL      64
+    int                 slot_count;
+    name_value_slot*    slots;
+    int                 i;
+
+    slot_count = aenv->slot_count ? 2 * aenv->slot_count : SLOT_COUNT_INITIAL;
+    slots = (name_value_slot*)ec_arena_alloc(aenv->arena,
+            slot_count * sizeof(name_value_slot));
+    if (slots == NULL)
+        return -1;
+    memset(slots, 0, slot_count * sizeof(name_value_slot));
+
+    for (i = 0; i < aenv->slot_count; ++i) {
+        unsigned int    j;
+
+        if (aenv->slots[i].index == 0)
+            continue;
+
+        for (j = aenv->slots[i].name_hash & (slot_count - 1);
+                slots[j].index != 0; j = (j + 1) & (slot_count - 1))
+            ;
+        slots[j] = aenv->slots[i];
+    }
+
+    aenv->slots = slots;
+    aenv->slot_count = slot_count;
+    return 0;
+#undef SLOT_COUNT_INITIAL
 }
 
+/*
+ * Add a name value to aenv, or replace the value if the name is there
+ * already. name is lowercase and name_hash is its ec_str_hash(). Return 0 on
+ * success, -1 if memory runs out.
+ */
 static int array_editorconfig_name_value_add(
         array_editorconfig_name_value* aenv,
-        const char* name, const char* value)
+        const char* name, unsigned int name_hash, const char* value)
 {
 #define VALUE_COUNT_INITIAL      30
 #define VALUE_COUNT_INCREASEMENT 10
-    int         name_value_pos;
-    /* always use name_lwr but not name, since property names are case
-     * insensitive */
-    char        name_lwr[MAX_PROPERTY_NAME];
+    name_value_slot*    slot;
+    unsigned int        i;
+
     /* For the first time we came here, aenv->name_values is NULL */
     if (aenv->name_values == NULL) {
-        aenv->name_values = (editorconfig_name_value*)malloc(
+        aenv->name_values = (editorconfig_name_value*)ec_arena_alloc(
+                aenv->arena,
                 sizeof(editorconfig_name_value) * VALUE_COUNT_INITIAL);
 
         if (aenv->name_values == NULL)
@@ -151,19 +289,26 @@ static int array_editorconfig_name_value_add(
         aenv->current_value_count = 0;
     }
 
+    /* keep the hash table at most half full */
+    if (2 * (aenv->current_value_count + 1) > aenv->slot_count &&
+            array_editorconfig_name_value_grow_slots(aenv) != 0)
+        return -1;
 
-    /* name_lwr is the lowercase property name */
-    strlwr(strcpy(name_lwr, name));
+    for (i = name_hash & (aenv->slot_count - 1); aenv->slots[i].index != 0;
+            i = (i + 1) & (aenv->slot_count - 1)) {
+        editorconfig_name_value*    nv;
 
-    name_value_pos = find_name_value_from_name(
-            aenv->name_values, aenv->current_value_count, name_lwr);
+        if (aenv->slots[i].name_hash != name_hash)
+            continue;
 
-    if (name_value_pos >= 0) { /* current name has already been used */
-        free(aenv->name_values[name_value_pos].value);
-        set_name_value(&aenv->name_values[name_value_pos],
-                (const char*)NULL, value, &aenv->spnvp);
-        return 0;
+        nv = &aenv->name_values[aenv->slots[i].index - 1];
+        if (!strcmp(nv->name, name)) {
+            /* current name has already been used */
+            return set_name_value(aenv->arena, nv, (const char*)NULL, value,
+                    &aenv->spnvp);
+        }
     }
+    slot = &aenv->slots[i];
 
     /* if the space is not enough, allocate more before add the new name and
      * value */
@@ -174,7 +319,9 @@ static int array_editorconfig_name_value_add(
 
         new_max_value_count = aenv->current_value_count +
             VALUE_COUNT_INCREASEMENT;
-        new_values = (editorconfig_name_value*)realloc(aenv->name_values,
+        new_values = (editorconfig_name_value*)ec_arena_grow(aenv->arena,
+                aenv->name_values,
+                sizeof(editorconfig_name_value) * aenv->max_value_count,
                 sizeof(editorconfig_name_value) * new_max_value_count);
 
         if (new_values == NULL) /* error occured */
@@ -187,150 +334,415 @@ static int array_editorconfig_name_value_add(
         reset_special_property_name_value_pointers(aenv);
     }
 
-    set_name_value(&aenv->name_values[aenv->current_value_count],
-            name_lwr, value, &aenv->spnvp);
+    if (set_name_value(aenv->arena,
+                &aenv->name_values[aenv->current_value_count],
+                name, value, &aenv->spnvp) != 0)
+        return -1;
     ++ aenv->current_value_count;
+    slot->name_hash = name_hash;
+    slot->index = aenv->current_value_count;
 
     return 0;
 #undef VALUE_COUNT_INITIAL
 #undef VALUE_COUNT_INCREASEMENT
 }
 
-static void array_editorconfig_name_value_clear(
-        array_editorconfig_name_value* aenv)
+/*
+ * Get the property name, whose hash is name_hash, among the properties
+ * resolved by the parse in hfparam. Return NULL if it is not resolved.
+ */
+static const ec_wanted_property* find_wanted_property(
+        const handler_first_param* hfparam, const char* name,
+        unsigned int name_hash)
 {
-    int             i;
+    int                  i;
 
-    for (i = 0; i < aenv->current_value_count; ++i) {
-        free(aenv->name_values[i].name);
-        free(aenv->name_values[i].value);
+    for (i = 0; i < hfparam->property_count; ++i)
+        if (hfparam->properties[i].name_hash == name_hash &&
+                !strcmp(hfparam->properties[i].name, name))
+            return &hfparam->properties[i];
+
+    return NULL;
+}
+
+/*
+ * Set wanted[i] to 1 if the ith section of cf sets a property resolved by
+ * the parse in hfparam, and to 0 otherwise. Return the count of sections
+ * wanted.
+ */
+static int find_wanted_sections(const handler_first_param* hfparam,
+        const ec_config_file* cf, unsigned char* wanted)
+{
+    int                  count = 0;
+    int                  i;
+    int                  j;
+
+    for (i = 0; i < cf->section_count; ++i) {
+        const ec_section*   section = &cf->sections[i];
+
+        wanted[i] = 0;
+        for (j = 0; j < section->property_count && !wanted[i]; ++j)
+            wanted[i] = find_wanted_property(hfparam,
+                    section->properties[j].name,
+                    section->properties[j].name_hash) != NULL;
+        count += wanted[i];
     }
 
-    free(aenv->name_values);
+    return count;
 }
 
 /*
- * Accept INI property value and store known values in handler_first_param
- * struct.
+ * Store the properties of the sections in cf which match the file in
+ * handler_first_param struct. Return 0 on success, -1 if memory runs out.
  */
-static int ini_handler(void* hfp, const char* section, const char* name,
-        const char* value)
+static int apply_config_file(handler_first_param* hfparam,
+        const ec_config_file* cf)
 {
-    handler_first_param* hfparam = (handler_first_param*)hfp;
-    /* prepend ** to pattern */
-    char*                pattern;
+#define MATCHED_ON_STACK    64
+    unsigned char        matched_on_stack[MATCHED_ON_STACK];
+    unsigned char        wanted_on_stack[MATCHED_ON_STACK];
+    unsigned char*       matched = matched_on_stack;
+    unsigned char*       wanted = NULL;
+    int                  err_num = 0;
+    int                  i;
+    int                  j;
+
+    if (cf->section_count > MATCHED_ON_STACK) {
+        matched = (unsigned char*)ec_arena_alloc(
+                hfparam->array_name_value.arena, cf->section_count);
+        if (!matched)
+            return -1;
+    }
 
-    /* root = true, clear all previous values */
-    if (*section == '\0' && !strcasecmp(name, "root") &&
-            !strcasecmp(value, "true")) {
-        array_editorconfig_name_value_clear(&hfparam->array_name_value);
-        array_editorconfig_name_value_init(&hfparam->array_name_value);
-        return 1;
+    if (hfparam->properties) {
+        wanted = wanted_on_stack;
+        if (cf->section_count > MATCHED_ON_STACK) {
+            wanted = (unsigned char*)ec_arena_alloc(
+                    hfparam->array_name_value.arena, cf->section_count);
+            if (!wanted)
+                return -1;
+        }
+    }
+
+    /* glob all the sections at once, but the ones setting none of the
+     * properties resolved. The file is not globbed at all if there is no
+     * other section. */
+    if (wanted && find_wanted_sections(hfparam, cf, wanted) == 0)
+        memset(matched, 0, cf->section_count);
+    else if (ec_config_file_match(cf, hfparam->full_filename, wanted,
+                matched) != 0)
+        err_num = -1;
+
+    for (i = 0; i < cf->section_count && err_num == 0; ++i) {
+        const ec_section*   section = &cf->sections[i];
+
+        /* the properties of a section not matching the file are skipped
+         * at once, only the preamble may set root */
+        if (!matched[i] && *section->name != '\0')
+            continue;
+
+        for (j = 0; j < section->property_count; ++j) {
+            const ec_property*  prop = &section->properties[j];
+
+            /* root = true, clear all previous values */
+            if (*section->name == '\0' && !strcasecmp(prop->name, "root") &&
+                    !strcasecmp(prop->value, "true")) {
+                array_editorconfig_name_value_init(&hfparam->array_name_value,
+                        hfparam->array_name_value.arena);
+                continue;
+            }
+
+            if (!matched[i] || (hfparam->properties && !find_wanted_property(
+                            hfparam, prop->name, prop->name_hash)))
+                continue;
+
+            if (array_editorconfig_name_value_add(
+                        &hfparam->array_name_value, prop->name,
+                        prop->name_hash, prop->value)) {
+                err_num = -1;
+                break;
+            }
+        }
     }
 
-    /* pattern would be: /dir/of/editorconfig/file[double_star]/[section] if
-     * section does not contain '/', or /dir/of/editorconfig/file[section]
-     * if section starts with a '/', or /dir/of/editorconfig/file/[section] if
-     * section contains '/' but does not start with '/' */
-    pattern = (char*)malloc(
-            strlen(hfparam->editorconfig_file_dir) * sizeof(char) +
-            sizeof("**/") + strlen(section) * sizeof(char));
-    if (!pattern)
+    return err_num;
+#undef MATCHED_ON_STACK
+}
+
+/*
+ * Whether the preamble of cf sets root = true
+ */
+static _Bool config_file_is_root(const ec_config_file* cf)
+{
+    int             j;
+
+    if (cf->section_count == 0 || *cf->sections[0].name != '\0')
         return 0;
-    strcpy(pattern, hfparam->editorconfig_file_dir);
 
-    if (strchr(section, '/') == NULL) /* No / is found, append '[star][star]/' */
-        strcat(pattern, "**/");
-    else if (*section != '/') /* The first char is not '/' but section contains
-                                 '/', append a '/' */
-        strcat(pattern, "/");
+    for (j = 0; j < cf->sections[0].property_count; ++j)
+        if (!strcasecmp(cf->sections[0].properties[j].name, "root") &&
+                !strcasecmp(cf->sections[0].properties[j].value, "true"))
+            return 1;
+
+    return 0;
+}
+
+/*
+ * A directory of config_tree below, which memoizes the EditorConfig files
+ * applying to the files in the directory.
+ */
+typedef struct config_dir
+{
+    /* the directory path, without the trailing slash */
+    char*                           dir;
+    unsigned int                    hash;
+    struct config_dir*              hash_next;
+    /* the EditorConfig file in the directory */
+    ec_config_file*                 cf;
+    /* the EditorConfig files which may apply to the files in the directory,
+     * from the top most one to cf. Only cf is owned by this directory, the
+     * others are owned by the parent directories. */
+    ec_config_file**                files;
+    int                             count;
+} config_dir;
+
+/*
+ * The directories visited while parsing some files, so that the EditorConfig
+ * files of a directory are looked up once for all the files in it and in its
+ * subdirectories. A file changed on disk after its directory has been visited
+ * is thus only seen by a later config_tree.
+ */
+typedef struct
+{
+    /* the memory of the tree, released by the owner of the arena */
+    ec_arena*                       arena;
+    const char*                     conf_file_name;
+    config_dir**                    buckets;
+    int                             bucket_count;
+    int                             count;
+    /* the directory of the last file looked up */
+    config_dir*                     last;
+} config_tree;
+
+static void config_tree_init(config_tree* tree, ec_arena* arena)
+{
+    memset(tree, 0, sizeof(config_tree));
+    tree->arena = arena;
+}
+
+/* Release the EditorConfig files of tree and empty it */
+static void config_tree_clear(config_tree* tree)
+{
+    int             i;
+    config_dir*     cd;
+
+    for (i = 0; i < tree->bucket_count; ++i)
+        for (cd = tree->buckets[i]; cd; cd = cd->hash_next)
+            ec_config_file_release(cd->cf);
 
-    strcat(pattern, section);
+    config_tree_init(tree, tree->arena);
+}
 
-    if (ec_glob(pattern, hfparam->full_filename) == 0) {
-        if (array_editorconfig_name_value_add(&hfparam->array_name_value, name,
-                value)) {
-            free(pattern);
-            return 0;
+/*
+ * Add cd to the hash table of tree. Return 0 on success, -1 if memory runs
+ * out.
+ */
+static int config_tree_insert(config_tree* tree, config_dir* cd)
+{
+    /* grow the table to keep the chains short */
+    if (tree->count >= tree->bucket_count) {
+        int             bucket_count = tree->bucket_count ?
+            2 * tree->bucket_count : 64;
+        config_dir**    buckets;
+        int             i;
+
+        buckets = (config_dir**)ec_arena_alloc(tree->arena,
+                bucket_count * sizeof(config_dir*));
+        if (!buckets)
+            return -1;
+        memset(buckets, 0, bucket_count * sizeof(config_dir*));
+        for (i = 0; i < tree->bucket_count; ++i) {
+            while (tree->buckets[i]) {
+                config_dir*     moved = tree->buckets[i];
+
+                tree->buckets[i] = moved->hash_next;
+                moved->hash_next = buckets[moved->hash % bucket_count];
+                buckets[moved->hash % bucket_count] = moved;
+            }
         }
+        tree->buckets = buckets;
+        tree->bucket_count = bucket_count;
     }
 
-    free(pattern);
-    return 1;
+    cd->hash_next = tree->buckets[cd->hash % tree->bucket_count];
+    tree->buckets[cd->hash % tree->bucket_count] = cd;
+    ++ tree->count;
+    return 0;
 }
 
-/* 
- * Split an absolute file path into directory and filename parts.
- *
- * If absolute_path does not contain a path separator, set directory and
- * filename to NULL pointers.
- */ 
-static void split_file_path(char** directory, char** filename,
-        const char* absolute_path)
-{
-    char* path_char = strrchr(absolute_path, '/');
-
-    if (path_char == NULL) {
-        if (directory)
-            *directory = NULL;
-        if (filename)
-            *filename = NULL;
-        return;
-    }
+/*
+ * Get the EditorConfig file of the directory cd->dir, at conf_path. Return 0
+ * on success, -1 if memory runs out.
+ */
+static int config_dir_acquire(config_dir* cd, const char* conf_path,
+        const char* conf_file_name)
+{
+    /* the parsed file comes from the cache unless it changed on disk. The
+     * directory is watched before the file is read, to miss no change. */
+    ec_watch_dir(cd->dir, conf_file_name);
+    cd->cf = ec_config_file_acquire(conf_path);
+    if (!cd->cf)
+        return -1;
+    if (cd->cf->stamp.exists)
+        ec_watch_file(conf_path);
+    return 0;
+}
 
-    if (directory != NULL) {
-        *directory = strndup(absolute_path,
-                (size_t)(path_char - absolute_path));
-    }
-    if (filename != NULL) {
-        *filename = strndup(path_char+1, strlen(path_char)-1);
+/*
+ * Set the EditorConfig files which may apply to the files in cd: the ones of
+ * parent followed by its own. parent is NULL for the top most directory, or
+ * if the file of cd has root = true. cd->files must have room for one more
+ * file than parent.
+ */
+static void config_dir_inherit(config_dir* cd, const config_dir* parent)
+{
+    cd->count = 0;
+    if (parent) {
+        memcpy(cd->files, parent->files,
+                parent->count * sizeof(ec_config_file*));
+        cd->count = parent->count;
     }
+
+    /* a missing or empty file applies nothing */
+    if (cd->cf->parse_error != 0 || cd->cf->section_count > 0)
+        cd->files[cd->count++] = cd->cf;
+}
+
+/*
+ * Visit the directory cd->dir, whose parent directory is parent, or NULL for
+ * the top most directory: get its EditorConfig file at conf_path, and the
+ * EditorConfig files which may apply to the files in it. cd->files must have
+ * room for one more file than parent. Return 0 on success, -1 if memory runs
+ * out.
+ */
+static int config_dir_load(config_dir* cd, const config_dir* parent,
+        const char* conf_path, const char* conf_file_name)
+{
+    if (config_dir_acquire(cd, conf_path, conf_file_name) != 0)
+        return -1;
+
+    config_dir_inherit(cd, config_file_is_root(cd->cf) ? NULL : parent);
+    return 0;
+}
+
+/*
+ * Get the directory dir of tree, whose hash is hash, if it has been visited.
+ * The tree is not changed.
+ */
+static config_dir* config_tree_find(const config_tree* tree, const char* dir,
+        unsigned int hash)
+{
+    config_dir*     cd;
+
+    if (tree->bucket_count == 0)
+        return NULL;
+
+    for (cd = tree->buckets[hash % tree->bucket_count]; cd;
+            cd = cd->hash_next)
+        if (cd->hash == hash && !strcmp(cd->dir, dir))
+            return cd;
+    return NULL;
 }
 
 /*
- * Return the number of slashes in given filename
+ * Get the directory dir of tree, visiting it and the parent directories not
+ * visited yet, nearest first: the directories above a file with root = true
+ * are not visited at all. dir is allocated from the arena of tree. Return
+ * NULL if memory runs out.
  */
-static int count_slashes(const char* filename)
+static config_dir* config_tree_get(config_tree* tree, char* dir)
 {
-    int slash_count;
-    for (slash_count = 0; *filename != '\0'; filename++) {
-        if (*filename == '/') {
-            slash_count++;
+    unsigned int    hash = ec_str_hash(dir);
+    config_dir*     cd;
+    config_dir*     parent = NULL;
+    const char*     slash;
+    char*           conf_path;
+
+    cd = config_tree_find(tree, dir, hash);
+    if (cd)
+        return cd;
+
+    cd = (config_dir*)ec_arena_alloc(tree->arena, sizeof(config_dir));
+    conf_path = (char*)ec_arena_alloc(tree->arena,
+            strlen(dir) + strlen(tree->conf_file_name) + 2);
+    if (!cd || !conf_path)
+        return NULL;
+    memset(cd, 0, sizeof(config_dir));
+    cd->dir = dir;
+    cd->hash = hash;
+    strcpy(conf_path, dir);
+    strcat(conf_path, "/");
+    strcat(conf_path, tree->conf_file_name);
+
+    if (config_dir_acquire(cd, conf_path, tree->conf_file_name) != 0)
+        return NULL;
+
+    /* the top most directory is the one without any slash, such as "" for
+     * "/" or "C:" on Windows */
+    slash = strrchr(dir, '/');
+    if (slash && !config_file_is_root(cd->cf)) {
+        char*           parent_dir = ec_arena_strndup(tree->arena, dir,
+                (size_t)(slash - dir));
+
+        if (!parent_dir || !(parent = config_tree_get(tree, parent_dir))) {
+            ec_config_file_release(cd->cf);
+            return NULL;
         }
     }
-    return slash_count;
+
+    cd->files = (ec_config_file**)ec_arena_alloc(tree->arena,
+            ((parent ? parent->count : 0) + 1) * sizeof(ec_config_file*));
+    if (!cd->files || config_tree_insert(tree, cd) != 0) {
+        ec_config_file_release(cd->cf);
+        return NULL;
+    }
+    config_dir_inherit(cd, parent);
+
+    return cd;
 }
 
 /*
- * Return an array of full filenames for files in every directory in and above
- * the given path with the name of the relative filename given.
+ * Get the directory of full_filename in tree, visiting it first if needed.
+ * The tree is reset if conf_file_name is not the one it was built for.
+ * Return 0 on success, EDITORCONFIG_PARSE_MEMORY_ERROR if memory runs out.
  */
-static char** get_filenames(const char* path, const char* filename)
+static int config_tree_lookup(config_tree* tree, const char* full_filename,
+        const char* conf_file_name, const config_dir** result)
 {
-    char* currdir;
-    char* currdir1;
-    char** files;
-    int slashes = count_slashes(path);
-    int i;
+    const char*     slash = strrchr(full_filename, '/');
+    size_t          dir_len;
+    char*           dir;
 
-    files = (char**) calloc(slashes+1, sizeof(char*));
+    if (tree->conf_file_name && strcmp(tree->conf_file_name, conf_file_name))
+        config_tree_clear(tree);
+    tree->conf_file_name = conf_file_name;
 
-    currdir = strdup(path);
-    for (i = slashes - 1; i >= 0; --i) {
-        currdir1 = currdir;
-        split_file_path(&currdir, NULL, currdir1);
-        free(currdir1);
-        files[i] = malloc(strlen(currdir) + strlen(filename) + 2);
-        strcpy(files[i], currdir);
-        strcat(files[i], "/");
-        strcat(files[i], filename);
-    }
+    /* an absolute path always has a slash, this is just in case */
+    dir_len = slash ? (size_t)(slash - full_filename) : 0;
 
-    free(currdir);
+    /* consecutive files are most likely in the same directory */
+    if (tree->last && strlen(tree->last->dir) == dir_len &&
+            !strncmp(tree->last->dir, full_filename, dir_len)) {
+        *result = tree->last;
+        return 0;
+    }
 
-    files[slashes] = NULL;
+    dir = ec_arena_strndup(tree->arena, full_filename, dir_len);
+    if (!dir || !(tree->last = config_tree_get(tree, dir)))
+        return EDITORCONFIG_PARSE_MEMORY_ERROR;
 
-    return files;
+    *result = tree->last;
+    return 0;
 }
 
 /*
@@ -376,25 +788,20 @@ const char* editorconfig_get_error_msg(int err_num)
         return "Memory error.";
     case EDITORCONFIG_PARSE_VERSION_TOO_NEW:
         return "Required version is greater than the current version.";
+    case EDITORCONFIG_PARSE_DIR_ERROR:
+        return "Failed to read directory.";
     }
 
     return "Unknown error.";
 }
 
-/* 
- * See the header file for the use of this function
+/*
+ * Check the version required by eh, and fill its defaults. Return 0 on
+ * success, or the error number to return.
  */
-EDITORCONFIG_EXPORT
-int editorconfig_parse(const char* full_filename, editorconfig_handle h)
+static int check_handle(struct editorconfig_handle* eh)
 {
-    handler_first_param                 hfp;
-    char**                              config_file;
-    char**                              config_files;
-    int                                 err_num;
-    int                                 i;
-    struct editorconfig_handle*         eh = (struct editorconfig_handle*)h;
     struct editorconfig_version         cur_ver;
-    struct editorconfig_version         tmp_ver;
 
     /* get current version */
     editorconfig_get_version(&cur_ver.major, &cur_ver.minor,
@@ -409,60 +816,116 @@ int editorconfig_parse(const char* full_filename, editorconfig_handle h)
     if (editorconfig_compare_version(&eh->ver, &cur_ver) > 0)
         return EDITORCONFIG_PARSE_VERSION_TOO_NEW;
 
-    if (!eh->err_file) {
-        free(eh->err_file);
-        eh->err_file = NULL;
-    }
-
     /* if eh->conf_file_name is NULL, we set ".editorconfig" as the default
      * conf file name */
     if (!eh->conf_file_name)
         eh->conf_file_name = ".editorconfig";
 
-    if (eh->name_values) {
-        /* free name_values */
-        for (i = 0; i < eh->name_value_count; ++i) {
-            free(eh->name_values[i].name);
-            free(eh->name_values[i].value);
-        }
-        free(eh->name_values);
-
-        eh->name_values = NULL;
-        eh->name_value_count = 0;
-    }
-    memset(&hfp, 0, sizeof(hfp));
+    return 0;
+}
 
-    hfp.full_filename = strdup(full_filename);
+/*
+ * Drop the result of the last parse of eh, and start the parse of
+ * full_filename in hfp. Return 0 on success, or the error number to return.
+ */
+static int start_parse(struct editorconfig_handle* eh,
+        const char* full_filename, handler_first_param* hfp)
+{
+    /* drop the result of the last parse, reusing its memory */
+    editorconfig_handle_reset((editorconfig_handle)eh);
+    memset(hfp, 0, sizeof(*hfp));
 
     /* return an error if file path is not absolute */
     if (!is_file_path_absolute(full_filename)) {
         return EDITORCONFIG_PARSE_NOT_FULL_PATH;
     }
 
+    hfp->full_filename = ec_arena_strdup(&eh->arena, full_filename);
+    if (!hfp->full_filename)
+        return EDITORCONFIG_PARSE_MEMORY_ERROR;
+
 #ifdef WIN32
     /* replace all backslashes with slashes on Windows */
-    str_replace(hfp.full_filename, '\\', '/');
+    str_replace(hfp->full_filename, '\\', '/');
 #endif
 
-    array_editorconfig_name_value_init(&hfp.array_name_value);
-
-    config_files = get_filenames(hfp.full_filename, eh->conf_file_name);
-    for (config_file = config_files; *config_file != NULL; config_file++) {
-        split_file_path(&hfp.editorconfig_file_dir, NULL, *config_file);
-        if ((err_num = ini_parse(*config_file, ini_handler, &hfp)) != 0 &&
-                /* ignore error caused by I/O, maybe caused by non exist file */
-                err_num != -1) {
-            eh->err_file = strdup(*config_file);
-            free(*config_file);
-            free(hfp.full_filename);
-            free(hfp.editorconfig_file_dir);
-            return err_num;
+    array_editorconfig_name_value_init(&hfp->array_name_value, &eh->arena);
+    hfp->properties = eh->properties;
+    hfp->property_count = eh->property_count;
+
+    return 0;
+}
+
+/*
+ * Store in eh a copy of the count names and values of name_values. Return 0
+ * on success, EDITORCONFIG_PARSE_MEMORY_ERROR if memory runs out.
+ */
+static int copy_result(struct editorconfig_handle* eh,
+        const editorconfig_name_value* name_values, int count)
+{
+    editorconfig_name_value*            nv;
+    int                                 i;
+
+    if (count == 0)
+        return 0;
+
+    nv = (editorconfig_name_value*)ec_arena_alloc(&eh->arena,
+            count * sizeof(editorconfig_name_value));
+    if (!nv)
+        return EDITORCONFIG_PARSE_MEMORY_ERROR;
+    for (i = 0; i < count; ++i) {
+        nv[i].name = ec_arena_strdup(&eh->arena, name_values[i].name);
+        nv[i].value = ec_arena_strdup(&eh->arena, name_values[i].value);
+        if (!nv[i].name || !nv[i].value)
+            return EDITORCONFIG_PARSE_MEMORY_ERROR;
+    }
+
+    eh->name_values = nv;
+    eh->name_value_count = count;
+    return 0;
+}
+
+/*
+ * Apply the EditorConfig files of cd, the directory of the file being parsed
+ * in hfp, and store the result in eh. If memo is not NULL, the result is
+ * looked up in memo first, and memoized there once resolved.
+ */
+static int finish_parse(struct editorconfig_handle* eh,
+        handler_first_param* hfp, const config_dir* cd, ec_memo* memo)
+{
+    int                                 err_num = 0;
+    int                                 i;
+    int                                 found = -1;
+    struct editorconfig_version         tmp_ver;
+
+    if (memo) {
+        const editorconfig_name_value*  name_values;
+        int                             name_value_count;
+
+        found = ec_memo_find(memo, hfp->full_filename, cd->files, cd->count,
+                eh, &name_values, &name_value_count);
+        if (found == 1)
+            return copy_result(eh, name_values, name_value_count);
+    }
+
+    for (i = 0; i < cd->count; ++i) {
+        const ec_config_file*   cf = cd->files[i];
+
+        if (cf->parse_error != 0) {
+            eh->err_file = ec_arena_strdup(&eh->arena, cf->path);
+            err_num = cf->parse_error;
+            break;
         }
 
-        free(hfp.editorconfig_file_dir);
-        free(*config_file);
+        if (apply_config_file(hfp, cf) != 0) {
+            err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+            break;
+        }
     }
 
+    if (err_num != 0)
+        return err_num;
+
     /* value proprocessing */
 
     /* For v0.9 */
@@ -470,52 +933,1479 @@ int editorconfig_parse(const char* full_filename, editorconfig_handle h)
     if (editorconfig_compare_version(&eh->ver, &tmp_ver) >= 0) {
     /* Set indent_size to "tab" if indent_size is not specified and
      * indent_style is set to "tab". Only should be done after v0.9 */
-        if (hfp.array_name_value.spnvp.indent_style &&
-                !hfp.array_name_value.spnvp.indent_size &&
-                !strcmp(hfp.array_name_value.spnvp.indent_style->value, "tab"))
-            array_editorconfig_name_value_add(&hfp.array_name_value,
-                    "indent_size", "tab");
+        if (hfp->array_name_value.spnvp.indent_style &&
+                !hfp->array_name_value.spnvp.indent_size &&
+                !strcmp(hfp->array_name_value.spnvp.indent_style->value, "tab"))
+            array_editorconfig_name_value_add(&hfp->array_name_value,
+                    "indent_size", ec_str_hash("indent_size"), "tab");
     /* Set indent_size to tab_width if indent_size is "tab" and tab_width is
      * specified. This behavior is specified for v0.9 and up. */
-        if (hfp.array_name_value.spnvp.indent_size &&
-            hfp.array_name_value.spnvp.tab_width &&
-            !strcmp(hfp.array_name_value.spnvp.indent_size->value, "tab"))
-        array_editorconfig_name_value_add(&hfp.array_name_value, "indent_size",
-                hfp.array_name_value.spnvp.tab_width->value);
+        if (hfp->array_name_value.spnvp.indent_size &&
+            hfp->array_name_value.spnvp.tab_width &&
+            !strcmp(hfp->array_name_value.spnvp.indent_size->value, "tab"))
+        array_editorconfig_name_value_add(&hfp->array_name_value, "indent_size",
+                ec_str_hash("indent_size"),
+                hfp->array_name_value.spnvp.tab_width->value);
     }
 
     /* Set tab_width to indent_size if indent_size is specified. If version is
      * not less than 0.9.0, we also need to check when the indent_size is set
      * to "tab", we should not duplicate the value to tab_width */
-    if (hfp.array_name_value.spnvp.indent_size &&
-            !hfp.array_name_value.spnvp.tab_width &&
+    if (hfp->array_name_value.spnvp.indent_size &&
+            !hfp->array_name_value.spnvp.tab_width &&
             (editorconfig_compare_version(&eh->ver, &tmp_ver) < 0 ||
-             strcmp(hfp.array_name_value.spnvp.indent_size->value, "tab")))
-        array_editorconfig_name_value_add(&hfp.array_name_value, "tab_width",
-                hfp.array_name_value.spnvp.indent_size->value);
+             strcmp(hfp->array_name_value.spnvp.indent_size->value, "tab")))
+        array_editorconfig_name_value_add(&hfp->array_name_value, "tab_width",
+                ec_str_hash("tab_width"),
+                hfp->array_name_value.spnvp.indent_size->value);
 
-    eh->name_value_count = hfp.array_name_value.current_value_count;
+    eh->name_value_count = hfp->array_name_value.current_value_count;
+    if (eh->name_value_count > 0)
+        eh->name_values = hfp->array_name_value.name_values;
 
-    if (eh->name_value_count == 0) {  /* no value is set, just return 0. */
-        free(hfp.full_filename);
-        free(config_files);
-        return 0;
-    }
-    eh->name_values = hfp.array_name_value.name_values;
-    eh->name_values = realloc(      /* realloc to truncate the unused spaces */
-            eh->name_values,
-            sizeof(editorconfig_name_value) * eh->name_value_count);
-    if (eh->name_values == NULL) {
-        free(hfp.full_filename);
-        return EDITORCONFIG_PARSE_MEMORY_ERROR;
+    /* the properties only resolved to compute the ones asked for are left
+     * out, keeping the order of the others */
+    if (hfp->properties) {
+        int             count = 0;
+
+        for (i = 0; i < eh->name_value_count; ++i) {
+            const ec_wanted_property*   prop = find_wanted_property(hfp,
+                    eh->name_values[i].name,
+                    ec_str_hash(eh->name_values[i].name));
+
+            if (prop && !prop->is_dependency)
+                eh->name_values[count++] = eh->name_values[i];
+        }
+        eh->name_value_count = count;
+        if (count == 0)
+            eh->name_values = NULL;
     }
 
-    free(hfp.full_filename);
-    free(config_files);
+    /* the files with the same results to the name tests of memo get the
+     * same result; running out of memory only loses the memoization */
+    if (found == 0)
+        ec_memo_add(memo, eh->name_values, eh->name_value_count);
 
     return 0;
 }
 
+/*
+ * Parse the EditorConfig files for full_filename, looking them up in tree,
+ * and the result in memo if it is not NULL.
+ */
+static int editorconfig_parse_with_tree(const char* full_filename,
+        editorconfig_handle h, config_tree* tree, ec_memo* memo)
+{
+    handler_first_param                 hfp;
+    const config_dir*                   cd;
+    int                                 err_num;
+    struct editorconfig_handle*         eh = (struct editorconfig_handle*)h;
+
+    err_num = check_handle(eh);
+    if (err_num != 0)
+        return err_num;
+
+    err_num = start_parse(eh, full_filename, &hfp);
+    if (err_num != 0)
+        return err_num;
+
+    err_num = config_tree_lookup(tree, hfp.full_filename,
+            eh->conf_file_name, &cd);
+    if (err_num != 0)
+        return err_num;
+
+    return finish_parse(eh, &hfp, cd, memo);
+}
+
+/* 
+ * See the header file for the use of this function
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_parse(const char* full_filename, editorconfig_handle h)
+{
+    struct editorconfig_handle*         eh = (struct editorconfig_handle*)h;
+    config_tree                         tree;
+    int                                 err_num;
+
+    /* the results are memoized for the files of the directory last parsed,
+     * so that parsing the files of a directory one by one is cheap */
+    if (!eh->memo)
+        eh->memo = (ec_memo*)calloc(1, sizeof(ec_memo));
+
+    /* the tree is released with the result of the next parse */
+    config_tree_init(&tree, &eh->arena);
+    err_num = editorconfig_parse_with_tree(full_filename, h, &tree,
+            eh->memo);
+    config_tree_clear(&tree);
+
+    return err_num;
+}
+
+/* 
+ * See the header file for the use of this function
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_parse_many(const char* const* full_filenames, int count,
+        editorconfig_handle* handles, int* err_nums)
+{
+    config_tree                         tree;
+    ec_arena                            tree_arena;
+    ec_memo                             memo;
+    int                                 err_num;
+    int                                 first_err_num = 0;
+    int                                 i;
+
+    /* the files share the lookup of the directories they have in common,
+     * and the results of the files of a directory given in a row */
+    memset(&tree_arena, 0, sizeof(tree_arena));
+    memset(&memo, 0, sizeof(memo));
+    config_tree_init(&tree, &tree_arena);
+    for (i = 0; i < count; ++i) {
+        err_num = editorconfig_parse_with_tree(full_filenames[i],
+                handles[i], &tree, &memo);
+
+        if (err_nums)
+            err_nums[i] = err_num;
+        if (err_num != 0 && first_err_num == 0)
+            first_err_num = err_num;
+    }
+    ec_memo_free(&memo);
+    config_tree_clear(&tree);
+    ec_arena_free(&tree_arena);
+
+    return first_err_num;
+}
+
+#ifdef EC_TREE_WALK
+/* The kinds of directory entries walked */
+#define TREE_ENTRY_OTHER    0
+#define TREE_ENTRY_FILE     1
+#define TREE_ENTRY_DIR      2
+
+/*
+ * Get the kind of entry, a directory entry of dir. The type of the entry
+ * comes with it on most file systems; symbolic links are not followed, as
+ * find does by default.
+ */
+static int tree_entry_kind(DIR* dir, const struct dirent* entry)
+{
+    struct stat             sb;
+
+    if (entry->d_name[0] == '.' && (entry->d_name[1] == '\0' ||
+                (entry->d_name[1] == '.' && entry->d_name[2] == '\0')))
+        return TREE_ENTRY_OTHER;
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+    if (entry->d_type != DT_UNKNOWN)
+        return entry->d_type == DT_REG ? TREE_ENTRY_FILE :
+            entry->d_type == DT_DIR ? TREE_ENTRY_DIR : TREE_ENTRY_OTHER;
+#endif
+
+    if (fstatat(dirfd(dir), entry->d_name, &sb, AT_SYMLINK_NOFOLLOW) != 0)
+        return TREE_ENTRY_OTHER;
+    return S_ISREG(sb.st_mode) ? TREE_ENTRY_FILE :
+        S_ISDIR(sb.st_mode) ? TREE_ENTRY_DIR : TREE_ENTRY_OTHER;
+}
+
+/*
+ * The state of editorconfig_parse_tree()
+ */
+typedef struct
+{
+    struct editorconfig_handle*     eh;
+    editorconfig_tree_callback      callback;
+    void*                           user_data;
+    /* the path of the directory or file being visited */
+    char*                           path;
+    size_t                          path_size;
+} tree_walk;
+
+/*
+ * Make room for size bytes in the path of walk. Return 0 on success, -1 if
+ * memory runs out.
+ */
+static int tree_walk_reserve(tree_walk* walk, size_t size)
+{
+    char*           path;
+    size_t          path_size = walk->path_size ? walk->path_size : 256;
+
+    if (size <= walk->path_size)
+        return 0;
+
+    while (path_size < size)
+        path_size *= 2;
+    path = (char*)realloc(walk->path, path_size);
+    if (!path)
+        return -1;
+    walk->path = path;
+    walk->path_size = path_size;
+    return 0;
+}
+
+/*
+ * Resolve the file at the path of walk, in the directory cd whose results
+ * are memoized in memo, and report it.
+ */
+static int tree_walk_file(tree_walk* walk, const config_dir* cd,
+        ec_memo* memo)
+{
+    handler_first_param     hfp;
+    int                     err_num;
+
+    err_num = start_parse(walk->eh, walk->path, &hfp);
+    if (err_num == 0)
+        err_num = finish_parse(walk->eh, &hfp, cd, memo);
+
+    return walk->callback(walk->path, err_num, (editorconfig_handle)walk->eh,
+            walk->user_data);
+}
+
+/*
+ * Report the error err_num on the directory at the path of walk.
+ */
+static int tree_walk_error(tree_walk* walk, int err_num)
+{
+    editorconfig_handle_reset((editorconfig_handle)walk->eh);
+    return walk->callback(walk->path, err_num, (editorconfig_handle)walk->eh,
+            walk->user_data);
+}
+
+static int tree_walk_subdir(tree_walk* walk, int fd, size_t len,
+        const config_dir* parent);
+
+/*
+ * Resolve the files in the directory opened as fd, whose path of length len
+ * is the path of walk, and whose EditorConfig files are in cd. fd is closed.
+ */
+static int tree_walk_dir(tree_walk* walk, int fd, size_t len,
+        const config_dir* cd)
+{
+    DIR*                    dir;
+    struct dirent*          entry;
+    ec_memo                 memo;
+    size_t                  name_len;
+    int                     kind;
+    int                     child_fd;
+    int                     ret = 0;
+
+    dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return tree_walk_error(walk, EDITORCONFIG_PARSE_DIR_ERROR);
+    }
+    memset(&memo, 0, sizeof(memo));
+
+    while (ret == 0 && (entry = readdir(dir))) {
+        kind = tree_entry_kind(dir, entry);
+        if (kind == TREE_ENTRY_OTHER)
+            continue;
+
+        name_len = strlen(entry->d_name);
+        if (tree_walk_reserve(walk, len + name_len + 2) != 0) {
+            ret = tree_walk_error(walk, EDITORCONFIG_PARSE_MEMORY_ERROR);
+            break;
+        }
+        walk->path[len] = '/';
+        memcpy(walk->path + len + 1, entry->d_name, name_len + 1);
+
+        if (kind == TREE_ENTRY_FILE)
+            ret = tree_walk_file(walk, cd, &memo);
+        else {
+            child_fd = openat(dirfd(dir), entry->d_name,
+                    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+            if (child_fd < 0)
+                ret = tree_walk_error(walk, EDITORCONFIG_PARSE_DIR_ERROR);
+            else
+                ret = tree_walk_subdir(walk, child_fd, len + 1 + name_len,
+                        cd);
+        }
+    }
+
+    closedir(dir);
+    ec_memo_free(&memo);
+    walk->path[len] = '\0';
+    return ret;
+}
+
+/*
+ * Visit the subdirectory opened as fd, whose path of length len is the path
+ * of walk, with the EditorConfig files of parent pushed with its own, and
+ * resolve the files in it. fd is closed.
+ */
+static int tree_walk_subdir(tree_walk* walk, int fd, size_t len,
+        const config_dir* parent)
+{
+    config_dir              cd;
+    char*                   conf_path;
+    int                     ret;
+
+    memset(&cd, 0, sizeof(cd));
+    cd.dir = walk->path;
+    cd.files = (ec_config_file**)malloc(
+            (parent->count + 1) * sizeof(ec_config_file*));
+    conf_path = (char*)malloc(len + strlen(walk->eh->conf_file_name) + 2);
+    if (conf_path) {
+        strcpy(conf_path, walk->path);
+        strcat(conf_path, "/");
+        strcat(conf_path, walk->eh->conf_file_name);
+    }
+    if (!cd.files || !conf_path || config_dir_load(&cd, parent, conf_path,
+                walk->eh->conf_file_name) != 0) {
+        free(cd.files);
+        free(conf_path);
+        close(fd);
+        return tree_walk_error(walk, EDITORCONFIG_PARSE_MEMORY_ERROR);
+    }
+    free(conf_path);
+
+    ret = tree_walk_dir(walk, fd, len, &cd);
+
+    ec_config_file_release(cd.cf);
+    free(cd.files);
+    return ret;
+}
+#endif /* EC_TREE_WALK */
+
+/*
+ * See the header file for the use of this function
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_parse_tree(const char* dir, editorconfig_handle h,
+        editorconfig_tree_callback callback, void* user_data)
+{
+#ifdef EC_TREE_WALK
+    struct editorconfig_handle*         eh = (struct editorconfig_handle*)h;
+    tree_walk                           walk;
+    config_tree                         tree;
+    ec_arena                            tree_arena;
+    const config_dir*                   cd;
+    char*                               tree_dir;
+    size_t                              len;
+    int                                 fd;
+    int                                 err_num;
+
+    err_num = check_handle(eh);
+    if (err_num != 0)
+        return err_num;
+
+    if (!is_file_path_absolute(dir))
+        return EDITORCONFIG_PARSE_NOT_FULL_PATH;
+
+    memset(&walk, 0, sizeof(walk));
+    walk.eh = eh;
+    walk.callback = callback;
+    walk.user_data = user_data;
+
+    /* the directories are kept without their trailing slash, "/" being "" */
+    len = strlen(dir);
+    while (len > 0 && dir[len - 1] == '/')
+        --len;
+    if (tree_walk_reserve(&walk, len + 1) != 0)
+        return EDITORCONFIG_PARSE_MEMORY_ERROR;
+    memcpy(walk.path, dir, len);
+    walk.path[len] = '\0';
+
+    fd = open(len > 0 ? walk.path : "/",
+            O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        free(walk.path);
+        return EDITORCONFIG_PARSE_DIR_ERROR;
+    }
+
+    /* the EditorConfig files of dir and of the directories above it are
+     * looked up as for a file in dir, those below are pushed by the walk */
+    memset(&tree_arena, 0, sizeof(tree_arena));
+    config_tree_init(&tree, &tree_arena);
+    tree.conf_file_name = eh->conf_file_name;
+    tree_dir = ec_arena_strdup(&tree_arena, walk.path);
+    if (!tree_dir || !(cd = config_tree_get(&tree, tree_dir))) {
+        close(fd);
+        err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+    } else
+        err_num = tree_walk_dir(&walk, fd, len, cd);
+
+    config_tree_clear(&tree);
+    ec_arena_free(&tree_arena);
+    free(walk.path);
+
+    return err_num;
+#else
+    (void)dir;
+    (void)h;
+    (void)callback;
+    (void)user_data;
+    return EDITORCONFIG_PARSE_DIR_ERROR;
+#endif /* EC_TREE_WALK */
+}
+
+#if defined(EC_TREE_WALK) && defined(CMAKE_USE_PTHREADS_INIT)
+/*
+ * The EditorConfig files of a directory walked by
+ * editorconfig_parse_tree_parallel(): an immutable snapshot of the config
+ * stack, shared by the tasks of the subdirectories and released by the last
+ * of them. A frame holds its parent, which owns the files above cd.cf.
+ */
+typedef struct tree_frame
+{
+    config_dir                      cd;
+    /* guarded by the mutex of the pool */
+    int                             ref_count;
+    struct tree_frame*              parent;
+} tree_frame;
+
+/*
+ * A file or a subdirectory of a directory walked with
+ * EDITORCONFIG_TREE_SORTED, whose result is kept until it is reported
+ */
+typedef struct
+{
+    char*                           path;
+    int                             err_num;
+    char*                           err_file;
+    editorconfig_name_value*        name_values;
+    int                             name_value_count;
+    _Bool                           is_dir;
+    /* the task of the subdirectory, NULL if it could not be created */
+    struct tree_task*               child;
+} tree_item;
+
+/* A directory to be walked by a worker of the pool */
+typedef struct tree_task
+{
+    char*                           path;
+    /* the frame of the parent directory, NULL for the top directory */
+    tree_frame*                     parent;
+    /* with EDITORCONFIG_TREE_SORTED, the entries in the order of their
+     * names, set once the task is done */
+    ec_arena                        arena;
+    tree_item*                      items;
+    int                             item_count;
+    int                             err_num;
+    _Bool                           is_done;
+} tree_task;
+
+/* The tasks of a worker: it takes the last one, thieves take the first one */
+typedef struct
+{
+    tree_task**                     tasks;
+    int                             first;
+    int                             count;
+    int                             capacity;
+    pthread_mutex_t                 mutex;
+} tree_deque;
+
+/* A level of the sorted report: the task being reported, and its next item */
+typedef struct
+{
+    tree_task*                      task;
+    int                             next;
+} tree_cursor;
+
+/* The state of editorconfig_parse_tree_parallel() */
+typedef struct
+{
+    const char*                     conf_file_name;
+    int                             flags;
+    editorconfig_tree_callback      callback;
+    void*                           user_data;
+    /* the frame of the top directory, set up from a config_tree */
+    tree_frame                      root;
+    tree_deque*                     deques;
+    int                             deque_count;
+
+    /* guards the counters below and the reference counts of the frames */
+    pthread_mutex_t                 mutex;
+    pthread_cond_t                  cond;
+    /* the tasks in the deques, the tasks not done yet, the idle workers */
+    int                             queued;
+    int                             pending;
+    int                             idle;
+    _Bool                           stopped;
+
+    /* guards the calls to the callback and the fields below */
+    pthread_mutex_t                 report_mutex;
+    int                             ret;
+    tree_cursor*                    cursors;
+    int                             depth;
+    int                             cursor_capacity;
+} tree_pool;
+
+/* A worker of the pool, with its own handle and deque */
+typedef struct
+{
+    tree_pool*                      pool;
+    int                             index;
+    struct editorconfig_handle*     eh;
+    /* the path of the file being resolved */
+    char*                           path;
+    size_t                          path_size;
+    pthread_t                       thread;
+} tree_worker;
+
+static void tree_frame_release(tree_pool* pool, tree_frame* frame)
+{
+    tree_frame*     parent;
+
+    while (frame) {
+        pthread_mutex_lock(&pool->mutex);
+        if (-- frame->ref_count > 0) {
+            pthread_mutex_unlock(&pool->mutex);
+            return;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+
+        parent = frame->parent;
+        ec_config_file_release(frame->cd.cf);
+        free(frame);
+        frame = parent;
+    }
+}
+
+static void tree_frame_retain(tree_pool* pool, tree_frame* frame)
+{
+    pthread_mutex_lock(&pool->mutex);
+    ++ frame->ref_count;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/* Free task, and the tasks of its subdirectories not reported yet */
+static void tree_task_free(tree_task* task, int first_item)
+{
+    int             i;
+
+    for (i = first_item; i < task->item_count; ++i)
+        if (task->items[i].child)
+            tree_task_free(task->items[i].child, 0);
+    ec_arena_free(&task->arena);
+    free(task->path);
+    free(task);
+}
+
+/*
+ * Create the task of the directory path, holding parent. Return NULL if
+ * memory runs out.
+ */
+static tree_task* tree_task_new(tree_pool* pool, const char* path,
+        tree_frame* parent)
+{
+    tree_task*      task = (tree_task*)malloc(sizeof(tree_task));
+
+    if (!task)
+        return NULL;
+    memset(task, 0, sizeof(tree_task));
+    task->path = strdup(path);
+    if (!task->path) {
+        free(task);
+        return NULL;
+    }
+    task->parent = parent;
+    if (parent)
+        tree_frame_retain(pool, parent);
+    return task;
+}
+
+/*
+ * Queue task in the deque of worker. Return 0 on success, -1 if memory runs
+ * out.
+ */
+static int tree_push(tree_worker* worker, tree_task* task)
+{
+    tree_pool*      pool = worker->pool;
+    tree_deque*     deque = &pool->deques[worker->index];
+
+    pthread_mutex_lock(&deque->mutex);
+    if (deque->count == deque->capacity) {
+        int             capacity = deque->capacity ? 2 * deque->capacity : 64;
+        tree_task**     tasks;
+        int             i;
+
+        tasks = (tree_task**)malloc(capacity * sizeof(tree_task*));
+        if (!tasks) {
+            pthread_mutex_unlock(&deque->mutex);
+            return -1;
+        }
+        for (i = 0; i < deque->count; ++i)
+            tasks[i] = deque->tasks[(deque->first + i) % deque->capacity];
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->first = 0;
+        deque->capacity = capacity;
+    }
+    deque->tasks[(deque->first + deque->count) % deque->capacity] = task;
+    ++ deque->count;
+    pthread_mutex_unlock(&deque->mutex);
+
+    pthread_mutex_lock(&pool->mutex);
+    ++ pool->queued;
+    ++ pool->pending;
+    if (pool->idle > 0)
+        pthread_cond_signal(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    return 0;
+}
+
+/*
+ * Take a task from deque: the last one for its owner, which walks depth
+ * first, the first one for a thief, which takes the largest part of the tree
+ * left.
+ */
+static tree_task* tree_deque_take(tree_deque* deque, _Bool is_owner)
+{
+    tree_task*      task = NULL;
+
+    pthread_mutex_lock(&deque->mutex);
+    if (deque->count > 0) {
+        if (is_owner)
+            task = deque->tasks[(deque->first + deque->count - 1) %
+                deque->capacity];
+        else {
+            task = deque->tasks[deque->first];
+            deque->first = (deque->first + 1) % deque->capacity;
+        }
+        -- deque->count;
+    }
+    pthread_mutex_unlock(&deque->mutex);
+
+    return task;
+}
+
+/*
+ * Take the next task of worker, stealing one from the other workers if its
+ * deque is empty, or waiting for one, and tell whether the walk is stopped.
+ * Return NULL once all the tasks are done.
+ */
+static tree_task* tree_take(tree_worker* worker, _Bool* stopped)
+{
+    tree_pool*      pool = worker->pool;
+    tree_task*      task;
+    int             i;
+
+    for (;;) {
+        task = tree_deque_take(&pool->deques[worker->index], 1);
+        for (i = 1; !task && i < pool->deque_count; ++i)
+            task = tree_deque_take(
+                    &pool->deques[(worker->index + i) % pool->deque_count], 0);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (task) {
+            -- pool->queued;
+            *stopped = pool->stopped;
+            pthread_mutex_unlock(&pool->mutex);
+            return task;
+        }
+        if (pool->pending == 0) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        /* a task queued since the deques were checked is taken at once */
+        if (pool->queued == 0) {
+            ++ pool->idle;
+            pthread_cond_wait(&pool->cond, &pool->mutex);
+            -- pool->idle;
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+/* Count task as done, waking up the idle workers if it was the last one */
+static void tree_task_done(tree_pool* pool)
+{
+    pthread_mutex_lock(&pool->mutex);
+    if (-- pool->pending == 0)
+        pthread_cond_broadcast(&pool->cond);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/*
+ * Stop the walk, which returns ret. The report mutex is held.
+ */
+static void tree_stop(tree_pool* pool, int ret)
+{
+    pool->ret = ret;
+    pthread_mutex_lock(&pool->mutex);
+    pool->stopped = 1;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+/*
+ * Call the callback for path, whose result is in eh, unless the walk is
+ * stopped. Return nonzero if the walk is stopped. The report mutex is held.
+ */
+static int tree_report(tree_pool* pool, const char* path, int err_num,
+        struct editorconfig_handle* eh)
+{
+    int             ret;
+
+    if (pool->ret != 0)
+        return pool->ret;
+
+    ret = pool->callback(path, err_num, (editorconfig_handle)eh,
+            pool->user_data);
+    if (ret != 0)
+        tree_stop(pool, ret);
+    return ret;
+}
+
+/*
+ * Report the items of the tasks done, in order, as far as possible. The
+ * report mutex is held.
+ */
+static void tree_report_sorted(tree_pool* pool,
+        struct editorconfig_handle* eh)
+{
+    tree_cursor*    cursor;
+    tree_item*      item;
+
+    while (pool->depth > 0 && pool->ret == 0) {
+        cursor = &pool->cursors[pool->depth - 1];
+        if (!cursor->task->is_done)
+            return;
+
+        if (cursor->next == cursor->task->item_count) {
+            if (cursor->task->err_num != 0) {
+                editorconfig_handle_reset((editorconfig_handle)eh);
+                tree_report(pool, cursor->task->path, cursor->task->err_num,
+                        eh);
+            }
+            tree_task_free(cursor->task, cursor->next);
+            -- pool->depth;
+            continue;
+        }
+
+        item = &cursor->task->items[cursor->next++];
+        if (item->is_dir && item->child) {
+            if (pool->depth == pool->cursor_capacity) {
+                int             capacity = 2 * pool->cursor_capacity;
+                tree_cursor*    cursors;
+
+                cursors = (tree_cursor*)realloc(pool->cursors,
+                        capacity * sizeof(tree_cursor));
+                if (!cursors) {
+                    /* the subdirectory is left to the cleanup */
+                    -- cursor->next;
+                    tree_stop(pool, EDITORCONFIG_PARSE_MEMORY_ERROR);
+                    return;
+                }
+                pool->cursors = cursors;
+                pool->cursor_capacity = capacity;
+            }
+            pool->cursors[pool->depth].task = item->child;
+            pool->cursors[pool->depth].next = 0;
+            ++ pool->depth;
+            continue;
+        }
+
+        /* the handle shows the result kept in the task */
+        editorconfig_handle_reset((editorconfig_handle)eh);
+        eh->err_file = item->err_file;
+        eh->name_values = item->name_values;
+        eh->name_value_count = item->name_value_count;
+        tree_report(pool, item->path, item->err_num, eh);
+    }
+}
+
+/*
+ * Resolve the file at path in the directory cd, whose results are memoized
+ * in memo, with the handle of worker.
+ */
+static int tree_resolve(tree_worker* worker, const char* path,
+        const config_dir* cd, ec_memo* memo)
+{
+    handler_first_param     hfp;
+    int                     err_num;
+
+    err_num = start_parse(worker->eh, path, &hfp);
+    if (err_num == 0)
+        err_num = finish_parse(worker->eh, &hfp, cd, memo);
+    return err_num;
+}
+
+/*
+ * Keep the result of the file of item, in the handle of worker, in the arena
+ * of task.
+ */
+static void tree_keep_result(tree_worker* worker, tree_task* task,
+        tree_item* item)
+{
+    struct editorconfig_handle*     eh = worker->eh;
+    int                             i;
+
+    if (eh->err_file && !(item->err_file =
+                ec_arena_strdup(&task->arena, eh->err_file)))
+        item->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+
+    if (eh->name_value_count == 0 || item->err_num != 0)
+        return;
+
+    item->name_values = (editorconfig_name_value*)ec_arena_alloc(
+            &task->arena, eh->name_value_count * sizeof(editorconfig_name_value));
+    if (!item->name_values) {
+        item->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+        return;
+    }
+    for (i = 0; i < eh->name_value_count; ++i) {
+        item->name_values[i].name = ec_arena_strdup(&task->arena,
+                eh->name_values[i].name);
+        item->name_values[i].value = ec_arena_strdup(&task->arena,
+                eh->name_values[i].value);
+        if (!item->name_values[i].name || !item->name_values[i].value) {
+            item->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+            return;
+        }
+    }
+    item->name_value_count = eh->name_value_count;
+}
+
+/*
+ * Get the frame of the directory of task, loading its EditorConfig file.
+ * Return NULL if memory runs out.
+ */
+static tree_frame* tree_frame_load(tree_pool* pool, tree_task* task)
+{
+    tree_frame*     parent = task->parent;
+    tree_frame*     frame;
+    char*           conf_path;
+    int             err_num;
+
+    if (!parent) {
+        tree_frame_retain(pool, &pool->root);
+        return &pool->root;
+    }
+
+    frame = (tree_frame*)malloc(sizeof(tree_frame) +
+            (parent->cd.count + 1) * sizeof(ec_config_file*));
+    conf_path = (char*)malloc(strlen(task->path) +
+            strlen(pool->conf_file_name) + 2);
+    if (!frame || !conf_path) {
+        free(frame);
+        free(conf_path);
+        return NULL;
+    }
+    memset(frame, 0, sizeof(tree_frame));
+    frame->cd.dir = task->path;
+    frame->cd.files = (ec_config_file**)(frame + 1);
+    strcpy(conf_path, task->path);
+    strcat(conf_path, "/");
+    strcat(conf_path, pool->conf_file_name);
+    err_num = config_dir_load(&frame->cd, &parent->cd, conf_path,
+            pool->conf_file_name);
+    free(conf_path);
+    if (err_num != 0) {
+        free(frame);
+        return NULL;
+    }
+
+    /* a directory without EditorConfig file shares the frame of its parent */
+    if (frame->cd.cf->parse_error == 0 && frame->cd.cf->section_count == 0) {
+        ec_config_file_release(frame->cd.cf);
+        free(frame);
+        tree_frame_retain(pool, parent);
+        return parent;
+    }
+
+    /* the task hands its reference of the parent over to the frame */
+    frame->ref_count = 1;
+    frame->parent = parent;
+    task->parent = NULL;
+    return frame;
+}
+
+/*
+ * Set the path of worker to the entry name of the directory dir_path.
+ * Return 0 on success, -1 if memory runs out.
+ */
+static int tree_worker_path(tree_worker* worker, const char* dir_path,
+        const char* name)
+{
+    size_t          size = strlen(dir_path) + strlen(name) + 2;
+
+    if (size > worker->path_size) {
+        char*           path = (char*)realloc(worker->path, 2 * size);
+
+        if (!path)
+            return -1;
+        worker->path = path;
+        worker->path_size = 2 * size;
+    }
+    strcpy(worker->path, dir_path);
+    strcat(worker->path, "/");
+    strcat(worker->path, name);
+    return 0;
+}
+
+/*
+ * Queue the task of the subdirectory at path, in the directory of frame.
+ * Return the task, or NULL if memory runs out.
+ */
+static tree_task* tree_push_subdir(tree_worker* worker, const char* path,
+        tree_frame* frame)
+{
+    tree_task*      child = tree_task_new(worker->pool, path, frame);
+
+    if (child && tree_push(worker, child) != 0) {
+        tree_frame_release(worker->pool, frame);
+        free(child->path);
+        free(child);
+        child = NULL;
+    }
+    return child;
+}
+
+/*
+ * Walk the entries of dir as they come, reporting the files at once.
+ */
+static void tree_walk_unsorted(tree_worker* worker, tree_task* task,
+        DIR* dir, tree_frame* frame, ec_memo* memo)
+{
+    tree_pool*      pool = worker->pool;
+    struct dirent*  entry;
+    int             kind;
+    int             err_num;
+    _Bool           stopped;
+
+    while ((entry = readdir(dir))) {
+        kind = tree_entry_kind(dir, entry);
+        if (kind == TREE_ENTRY_OTHER)
+            continue;
+
+        if (tree_worker_path(worker, task->path, entry->d_name) != 0)
+            err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+        else if (kind == TREE_ENTRY_DIR) {
+            if (tree_push_subdir(worker, worker->path, frame))
+                continue;
+            err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+        } else
+            err_num = tree_resolve(worker, worker->path, &frame->cd, memo);
+
+        if (err_num == EDITORCONFIG_PARSE_MEMORY_ERROR)
+            editorconfig_handle_reset((editorconfig_handle)worker->eh);
+        pthread_mutex_lock(&pool->report_mutex);
+        stopped = tree_report(pool, worker->path, err_num, worker->eh) != 0;
+        pthread_mutex_unlock(&pool->report_mutex);
+        if (stopped)
+            break;
+    }
+}
+
+/* Compare the paths of two items of the same directory */
+static int tree_compare_paths(const void* a, const void* b)
+{
+    return strcmp((*(const tree_item* const*)a)->path,
+            (*(const tree_item* const*)b)->path);
+}
+
+/*
+ * Walk the entries of dir in the order of their names, keeping the results
+ * of the files in task. The subdirectories are queued first, so that the
+ * other workers can start on them.
+ */
+static void tree_walk_sorted(tree_worker* worker, tree_task* task,
+        DIR* dir, tree_frame* frame, ec_memo* memo)
+{
+    struct dirent*  entry;
+    tree_item**     sorted = NULL;
+    tree_item*      item;
+    int             kind;
+    int             capacity = 0;
+    int             count = 0;
+    int             i;
+
+    /* the items are allocated one by one, and sorted through pointers */
+    while ((entry = readdir(dir))) {
+        kind = tree_entry_kind(dir, entry);
+        if (kind == TREE_ENTRY_OTHER)
+            continue;
+
+        if (count == capacity) {
+            tree_item**     grown;
+
+            capacity = capacity ? 2 * capacity : 64;
+            grown = (tree_item**)realloc(sorted,
+                    capacity * sizeof(tree_item*));
+            if (!grown)
+                break;
+            sorted = grown;
+        }
+        item = (tree_item*)ec_arena_alloc(&task->arena, sizeof(tree_item));
+        if (!item || tree_worker_path(worker, task->path, entry->d_name) != 0
+                || !(item->path = ec_arena_strdup(&task->arena,
+                        worker->path)))
+            break;
+        item->err_num = 0;
+        item->err_file = NULL;
+        item->name_values = NULL;
+        item->name_value_count = 0;
+        item->is_dir = kind == TREE_ENTRY_DIR;
+        item->child = NULL;
+        sorted[count++] = item;
+    }
+    if (entry) {
+        /* memory ran out, the directory is reported as not read */
+        free(sorted);
+        task->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+        return;
+    }
+
+    task->items = (tree_item*)ec_arena_alloc(&task->arena,
+            (count ? count : 1) * sizeof(tree_item));
+    if (!task->items) {
+        free(sorted);
+        task->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+        return;
+    }
+    qsort(sorted, count, sizeof(tree_item*), tree_compare_paths);
+    for (i = 0; i < count; ++i)
+        task->items[i] = *sorted[i];
+    free(sorted);
+
+    /* queued last to first, so that the owner walks the first one next */
+    for (i = count - 1; i >= 0; --i) {
+        item = &task->items[i];
+        if (!item->is_dir)
+            continue;
+        item->child = tree_push_subdir(worker, item->path, frame);
+        if (!item->child)
+            item->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+    }
+
+    for (i = 0; i < count; ++i) {
+        item = &task->items[i];
+        if (item->is_dir)
+            continue;
+        item->err_num = tree_resolve(worker, item->path, &frame->cd, memo);
+        tree_keep_result(worker, task, item);
+    }
+
+    task->item_count = count;
+}
+
+/* Walk the directory of task */
+static void tree_walk_task(tree_worker* worker, tree_task* task)
+{
+    tree_pool*      pool = worker->pool;
+    tree_frame*     frame = NULL;
+    DIR*            dir = NULL;
+    ec_memo         memo;
+    int             fd;
+
+    memset(&memo, 0, sizeof(memo));
+
+    /* the top directory may be a symbolic link, not the ones below it */
+    fd = open(*task->path ? task->path : "/", O_RDONLY | O_DIRECTORY |
+            O_CLOEXEC | (task->parent ? O_NOFOLLOW : 0));
+    if (fd >= 0 && !(dir = fdopendir(fd)))
+        close(fd);
+
+    if (!dir)
+        task->err_num = EDITORCONFIG_PARSE_DIR_ERROR;
+    else if (!(frame = tree_frame_load(pool, task)))
+        task->err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+    else if (pool->flags & EDITORCONFIG_TREE_SORTED)
+        tree_walk_sorted(worker, task, dir, frame, &memo);
+    else
+        tree_walk_unsorted(worker, task, dir, frame, &memo);
+
+    if (dir)
+        closedir(dir);
+    ec_memo_free(&memo);
+    tree_frame_release(pool, frame);
+    tree_frame_release(pool, task->parent);
+    task->parent = NULL;
+}
+
+static void* tree_worker_run(void* arg)
+{
+    tree_worker*    worker = (tree_worker*)arg;
+    tree_pool*      pool = worker->pool;
+    tree_task*      task;
+    _Bool           stopped;
+
+    while ((task = tree_take(worker, &stopped))) {
+        /* once stopped, the tasks left are only released */
+        if (!stopped)
+            tree_walk_task(worker, task);
+        else {
+            tree_frame_release(pool, task->parent);
+            task->parent = NULL;
+        }
+
+        if (pool->flags & EDITORCONFIG_TREE_SORTED) {
+            pthread_mutex_lock(&pool->report_mutex);
+            task->is_done = 1;
+            tree_report_sorted(pool, worker->eh);
+            pthread_mutex_unlock(&pool->report_mutex);
+        } else {
+            if (task->err_num != 0) {
+                editorconfig_handle_reset((editorconfig_handle)worker->eh);
+                pthread_mutex_lock(&pool->report_mutex);
+                tree_report(pool, task->path, task->err_num, worker->eh);
+                pthread_mutex_unlock(&pool->report_mutex);
+            }
+            tree_task_free(task, 0);
+        }
+
+        tree_task_done(pool);
+    }
+
+    return NULL;
+}
+#endif /* EC_TREE_WALK && CMAKE_USE_PTHREADS_INIT */
+
+/*
+ * See the header file for the use of this function
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_parse_tree_parallel(const char* dir, editorconfig_handle h,
+        int jobs, int flags, editorconfig_tree_callback callback,
+        void* user_data)
+{
+#if defined(EC_TREE_WALK) && defined(CMAKE_USE_PTHREADS_INIT)
+    struct editorconfig_handle*         eh = (struct editorconfig_handle*)h;
+    tree_pool                           pool;
+    tree_worker*                        workers;
+    tree_task*                          root;
+    config_tree                         tree;
+    ec_arena                            tree_arena;
+    const config_dir*                   cd;
+    char*                               path;
+    size_t                              len;
+    int                                 started;
+    int                                 fd;
+    int                                 err_num;
+    int                                 i;
+
+    err_num = check_handle(eh);
+    if (err_num != 0)
+        return err_num;
+
+    if (!is_file_path_absolute(dir))
+        return EDITORCONFIG_PARSE_NOT_FULL_PATH;
+
+    if (jobs < 1)
+        jobs = 1;
+
+    /* the directories are kept without their trailing slash, "/" being "" */
+    len = strlen(dir);
+    while (len > 0 && dir[len - 1] == '/')
+        --len;
+
+    /* the top directory not read is an error of the call, as for
+     * editorconfig_parse_tree() */
+    fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return EDITORCONFIG_PARSE_DIR_ERROR;
+    close(fd);
+
+    memset(&pool, 0, sizeof(pool));
+    pool.conf_file_name = eh->conf_file_name;
+    pool.flags = flags;
+    pool.callback = callback;
+    pool.user_data = user_data;
+    pool.deque_count = jobs;
+
+    /* the EditorConfig files of dir and of the directories above it are
+     * looked up as for a file in dir, those below are pushed by the walk */
+    memset(&tree_arena, 0, sizeof(tree_arena));
+    config_tree_init(&tree, &tree_arena);
+    tree.conf_file_name = eh->conf_file_name;
+    path = ec_arena_strndup(&tree_arena, dir, len);
+    workers = (tree_worker*)calloc(jobs, sizeof(tree_worker));
+    pool.deques = (tree_deque*)calloc(jobs, sizeof(tree_deque));
+    pool.cursor_capacity = 16;
+    pool.cursors = (tree_cursor*)malloc(
+            pool.cursor_capacity * sizeof(tree_cursor));
+    if (!path || !workers || !pool.deques || !pool.cursors ||
+            !(cd = config_tree_get(&tree, path))) {
+        free(workers);
+        free(pool.deques);
+        free(pool.cursors);
+        config_tree_clear(&tree);
+        ec_arena_free(&tree_arena);
+        return EDITORCONFIG_PARSE_MEMORY_ERROR;
+    }
+
+    /* the root frame is never released: the pool holds a reference, and its
+     * EditorConfig files are owned by tree */
+    pool.root.cd = *cd;
+    pool.root.cd.cf = NULL;
+    pool.root.ref_count = 1;
+
+    pthread_mutex_init(&pool.mutex, NULL);
+    pthread_cond_init(&pool.cond, NULL);
+    pthread_mutex_init(&pool.report_mutex, NULL);
+    for (i = 0; i < jobs; ++i) {
+        pthread_mutex_init(&pool.deques[i].mutex, NULL);
+        workers[i].pool = &pool;
+        workers[i].index = i;
+        workers[i].eh = (struct editorconfig_handle*)
+            editorconfig_handle_init();
+        if (!workers[i].eh)
+            err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+        else {
+            workers[i].eh->conf_file_name = eh->conf_file_name;
+            workers[i].eh->ver = eh->ver;
+            /* borrowed from eh, and given back before the handle is
+             * destroyed */
+            workers[i].eh->properties = eh->properties;
+            workers[i].eh->property_count = eh->property_count;
+        }
+    }
+
+    root = err_num == 0 ? tree_task_new(&pool, path, NULL) : NULL;
+    if (root && tree_push(&workers[0], root) != 0) {
+        tree_task_free(root, 0);
+        root = NULL;
+    }
+    if (!root)
+        err_num = EDITORCONFIG_PARSE_MEMORY_ERROR;
+    else {
+        pool.cursors[0].task = root;
+        pool.cursors[0].next = 0;
+        pool.depth = (flags & EDITORCONFIG_TREE_SORTED) ? 1 : 0;
+
+        /* the calling thread is the first worker, the others are started as
+         * long as threads can be created */
+        for (started = 1; started < jobs; ++started)
+            if (pthread_create(&workers[started].thread, NULL,
+                        tree_worker_run, &workers[started]) != 0)
+                break;
+        tree_worker_run(&workers[0]);
+        for (i = 1; i < started; ++i)
+            pthread_join(workers[i].thread, NULL);
+
+        /* a stopped walk leaves the tasks not reported yet */
+        for (i = pool.depth - 1; i >= 0; --i)
+            tree_task_free(pool.cursors[i].task, pool.cursors[i].next);
+
+        err_num = pool.ret;
+    }
+
+    for (i = 0; i < jobs; ++i) {
+        if (workers[i].eh) {
+            workers[i].eh->properties = NULL;
+            workers[i].eh->property_count = 0;
+            editorconfig_handle_destroy((editorconfig_handle)workers[i].eh);
+        }
+        free(workers[i].path);
+        free(pool.deques[i].tasks);
+        pthread_mutex_destroy(&pool.deques[i].mutex);
+    }
+    pthread_mutex_destroy(&pool.report_mutex);
+    pthread_cond_destroy(&pool.cond);
+    pthread_mutex_destroy(&pool.mutex);
+    free(pool.cursors);
+    free(pool.deques);
+    free(workers);
+    config_tree_clear(&tree);
+    ec_arena_free(&tree_arena);
+
+    return err_num;
+#else
+    /* without threads, the files are resolved by the calling thread in the
+     * order of the directory entries */
+    (void)jobs;
+    (void)flags;
+    return editorconfig_parse_tree(dir, h, callback, user_data);
+#endif
+}
+
+/*
+ * The state of an editorconfig_config_set: the directories of tree are all
+ * visited by editorconfig_config_set_new(), and the set is never changed
+ * afterwards.
+ */
+typedef struct
+{
+    ec_arena                        arena;
+    config_tree                     tree;
+    char*                           conf_file_name;
+} config_set;
+
+#ifdef EC_TREE_WALK
+/*
+ * Visit the directory opened as fd, whose path of length len is the path of
+ * walk, and its subdirectories. The directories that cannot be read are left
+ * out. fd is closed. Return 0 on success, -1 if memory runs out.
+ */
+static int config_set_load_dir(config_set* set, tree_walk* walk, int fd,
+        size_t len)
+{
+    DIR*                    dir;
+    struct dirent*          entry;
+    char*                   dir_path;
+    size_t                  name_len;
+    int                     child_fd;
+    int                     ret = 0;
+
+    dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return 0;
+    }
+
+    dir_path = ec_arena_strndup(&set->arena, walk->path, len);
+    if (!dir_path || !config_tree_get(&set->tree, dir_path))
+        ret = -1;
+
+    while (ret == 0 && (entry = readdir(dir))) {
+        if (tree_entry_kind(dir, entry) != TREE_ENTRY_DIR)
+            continue;
+
+        name_len = strlen(entry->d_name);
+        if (tree_walk_reserve(walk, len + name_len + 2) != 0) {
+            ret = -1;
+            break;
+        }
+        walk->path[len] = '/';
+        memcpy(walk->path + len + 1, entry->d_name, name_len + 1);
+
+        child_fd = openat(dirfd(dir), entry->d_name,
+                O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (child_fd >= 0)
+            ret = config_set_load_dir(set, walk, child_fd,
+                    len + 1 + name_len);
+    }
+
+    closedir(dir);
+    return ret;
+}
+#endif /* EC_TREE_WALK */
+
+/*
+ * See the header file for the use of this function
+ */
+EDITORCONFIG_EXPORT
+editorconfig_config_set editorconfig_config_set_new(const char* dir,
+        const char* conf_file_name)
+{
+    config_set*                         set;
+    size_t                              len;
+    char*                               top;
+    int                                 err_num = 0;
+
+    if (!is_file_path_absolute(dir))
+        return NULL;
+
+    set = (config_set*)malloc(sizeof(config_set));
+    if (!set)
+        return NULL;
+    memset(&set->arena, 0, sizeof(set->arena));
+    config_tree_init(&set->tree, &set->arena);
+    set->conf_file_name = strdup(conf_file_name ? conf_file_name :
+            ".editorconfig");
+    if (!set->conf_file_name) {
+        free(set);
+        return NULL;
+    }
+    set->tree.conf_file_name = set->conf_file_name;
+
+    /* the directories are kept without their trailing slash, "/" being "" */
+    len = strlen(dir);
+    while (len > 0 && dir[len - 1] == '/')
+        --len;
+
+#ifdef EC_TREE_WALK
+    {
+        tree_walk                       walk;
+        int                             fd;
+
+        /* only the path of the walk is used */
+        memset(&walk, 0, sizeof(walk));
+        if (tree_walk_reserve(&walk, len + 1) != 0)
+            err_num = -1;
+        else {
+            memcpy(walk.path, dir, len);
+            walk.path[len] = '\0';
+            fd = open(len > 0 ? walk.path : "/",
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd >= 0)
+                err_num = config_set_load_dir(set, &walk, fd, len);
+        }
+        free(walk.path);
+    }
+#endif /* EC_TREE_WALK */
+
+    /* without a walk, or if dir cannot be read, only the directories above
+     * the files of dir are loaded */
+    if (err_num == 0) {
+        top = ec_arena_strndup(&set->arena, dir, len);
+        if (!top || !config_tree_get(&set->tree, top))
+            err_num = -1;
+    }
+
+    if (err_num != 0) {
+        editorconfig_config_set_destroy((editorconfig_config_set)set);
+        return NULL;
+    }
+
+    return (editorconfig_config_set)set;
+}
+
+/*
+ * See the header file for the use of this function
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_config_set_query(editorconfig_config_set s,
+        const char* full_filename, editorconfig_handle h)
+{
+    const config_set*                   set = (const config_set*)s;
+    struct editorconfig_handle*         eh = (struct editorconfig_handle*)h;
+    handler_first_param                 hfp;
+    const config_dir*                   cd;
+    config_tree                         tree;
+    const char*                         slash;
+    char*                               dir;
+    int                                 err_num;
+
+    err_num = check_handle(eh);
+    if (err_num != 0)
+        return err_num;
+
+    err_num = start_parse(eh, full_filename, &hfp);
+    if (err_num != 0)
+        return err_num;
+
+    /* the directory is looked up without changing the set, so that the set
+     * can be queried by several threads at once */
+    slash = strrchr(hfp.full_filename, '/');
+    dir = ec_arena_strndup(&eh->arena, hfp.full_filename,
+            slash ? (size_t)(slash - hfp.full_filename) : 0);
+    if (!dir)
+        return EDITORCONFIG_PARSE_MEMORY_ERROR;
+    cd = config_tree_find(&set->tree, dir, ec_str_hash(dir));
+    if (cd)
+        return finish_parse(eh, &hfp, cd, NULL);
+
+    /* a directory outside of the set, or created after it, is visited as
+     * editorconfig_parse() does */
+    config_tree_init(&tree, &eh->arena);
+    err_num = config_tree_lookup(&tree, hfp.full_filename,
+            set->conf_file_name, &cd);
+    if (err_num == 0)
+        err_num = finish_parse(eh, &hfp, cd, NULL);
+    config_tree_clear(&tree);
+
+    return err_num;
+}
+
+/*
+ * See the header file for the use of this function
+ */
+EDITORCONFIG_EXPORT
+void editorconfig_config_set_destroy(editorconfig_config_set s)
+{
+    config_set*                         set = (config_set*)s;
+
+    if (!set)
+        return;
+
+    config_tree_clear(&set->tree);
+    ec_arena_free(&set->arena);
+    free(set->conf_file_name);
+    free(set);
+}
+
 /*
  * See header file
  */
@@ -25,6 +25,8 @@
  */
 
 #include "editorconfig_handle.h"
+#include "misc.h"
+#include "ec_memo.h"
 
 /*
  * See header file
@@ -50,23 +52,23 @@ editorconfig_handle editorconfig_handle_init(void)
 EDITORCONFIG_EXPORT
 int editorconfig_handle_destroy(editorconfig_handle h)
 {
-    int                             i;
     struct editorconfig_handle*     eh = (struct editorconfig_handle*)h;
 
 
     if (h == NULL)
         return 0;
 
-    /* free name_values */
-    for (i = 0; i < eh->name_value_count; ++i) {
-        free(eh->name_values[i].name);
-        free(eh->name_values[i].value);
-    }
-    free(eh->name_values);
+    /* free err_file and name_values */
+    ec_arena_free(&eh->arena);
 
-    /* free err_file */
-    if (eh->err_file)
-        free(eh->err_file);
+    /* free the properties asked for */
+    editorconfig_handle_set_properties(h, NULL, 0);
+
+    /* free the memoized results */
+    if (eh->memo) {
+        ec_memo_free(eh->memo);
+        free(eh->memo);
+    }
 
     /* free eh itself */
     free(eh);
@@ -74,6 +76,22 @@ int editorconfig_handle_destroy(editorconfig_handle h)
     return 0;
 }
 
+/*
+ * See header file
+ */
+EDITORCONFIG_EXPORT
+void editorconfig_handle_reset(editorconfig_handle h)
+{
+    struct editorconfig_handle*     eh = (struct editorconfig_handle*)h;
+
+    /* free err_file and name_values, keeping their memory for the next
+     * parse */
+    ec_arena_reset(&eh->arena);
+    eh->err_file = NULL;
+    eh->name_values = NULL;
+    eh->name_value_count = 0;
+}
+
 /*
  * See header file
  */
@@ -153,3 +171,84 @@ int editorconfig_handle_get_name_value_count(const editorconfig_handle h)
 {
     return ((const struct editorconfig_handle*)h)->name_value_count;
 }
+
+/*
+ * Add the property name to the properties of eh, unless it is there already.
+ * Return 0 on success, -1 if memory runs out.
+ */
+static int add_wanted_property(struct editorconfig_handle* eh,
+        const char* name, _Bool is_dependency)
+{
+    ec_wanted_property*     prop;
+    char*                   lower;
+    int                     i;
+
+    lower = strdup(name);
+    if (!lower)
+        return -1;
+    strlwr(lower);
+
+    for (i = 0; i < eh->property_count; ++i) {
+        if (!strcmp(eh->properties[i].name, lower)) {
+            /* asked for, even if another one depends on it */
+            if (!is_dependency)
+                eh->properties[i].is_dependency = 0;
+            free(lower);
+            return 0;
+        }
+    }
+
+    prop = &eh->properties[eh->property_count++];
+    prop->name = lower;
+    prop->name_hash = ec_str_hash(lower);
+    prop->is_dependency = is_dependency;
+    return 0;
+}
+
+/*
+ * See header file
+ */
+EDITORCONFIG_EXPORT
+int editorconfig_handle_set_properties(editorconfig_handle h,
+        const char* const* names, int count)
+{
+    struct editorconfig_handle*     eh = (struct editorconfig_handle*)h;
+    int                             i;
+
+    for (i = 0; i < eh->property_count; ++i)
+        free(eh->properties[i].name);
+    free(eh->properties);
+    eh->properties = NULL;
+    eh->property_count = 0;
+
+    if (!names)
+        return 0;
+
+    /* the values of indent_size and tab_width are computed from the other
+     * indentation properties when they are not set, see finish_parse() in
+     * editorconfig.c. Two more properties are thus resolved at most. */
+    eh->properties = (ec_wanted_property*)malloc(
+            (count + 2) * sizeof(ec_wanted_property));
+    if (!eh->properties)
+        return -1;
+
+    for (i = 0; i < count; ++i) {
+        if (add_wanted_property(eh, names[i], 0) != 0)
+            break;
+
+        if (!strcasecmp(names[i], "indent_size")) {
+            if (add_wanted_property(eh, "indent_style", 1) != 0 ||
+                    add_wanted_property(eh, "tab_width", 1) != 0)
+                break;
+        } else if (!strcasecmp(names[i], "tab_width")) {
+            if (add_wanted_property(eh, "indent_size", 1) != 0)
+                break;
+        }
+    }
+
+    if (i < count) {
+        editorconfig_handle_set_properties(h, NULL, 0);
+        return -1;
+    }
+    return 0;
+}
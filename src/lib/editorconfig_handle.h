@@ -30,6 +30,8 @@
 #include "global.h"
 #include <editorconfig/editorconfig_handle.h>
 
+#include "ec_arena.h"
+
 /*!
  * @brief A structure containing a name and its corresponding value.
  * @author EditorConfig Team
@@ -56,6 +58,20 @@ struct editorconfig_version
     int                     patch;
 };
 
+/*
+ * A property resolved by the parses of a handle, see
+ * editorconfig_handle_set_properties()
+ */
+typedef struct ec_wanted_property
+{
+    /* lowercase name, and its ec_str_hash() */
+    char*                   name;
+    unsigned int            name_hash;
+    /* whether it is only resolved to compute the value of another one, and
+     * left out of the result */
+    _Bool                   is_dependency;
+} ec_wanted_property;
+
 struct editorconfig_handle
 {
     /*!
@@ -83,6 +99,26 @@ struct editorconfig_handle
     /*! The total count of name_values structures pointed by name_values
      * pointer */
     int                                 name_value_count;
+
+    /*!
+     * The memory of a parse: err_file, name_values and the names and values
+     * are allocated from it. It is reset by the next parse, so that parsing
+     * again with the same handle reuses the memory.
+     */
+    ec_arena                            arena;
+
+    /*!
+     * The properties resolved by the parses, or NULL for all of them. See
+     * editorconfig_handle_set_properties().
+     */
+    ec_wanted_property*                 properties;
+    int                                 property_count;
+
+    /*!
+     * The results memoized by editorconfig_parse() for the files of the
+     * directory of its last parse, allocated by the first parse.
+     */
+    struct ec_memo*                     memo;
 };
 
 #endif /* !__EDITORCONFIG_HANDLE_H__ */
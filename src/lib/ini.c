@@ -40,136 +40,147 @@ http://code.google.com/p/inih/
 
 #include "ini.h"
 
-#define MAX_LINE 200
-#define MAX_SECTION MAX_SECTION_NAME
-#define MAX_NAME MAX_PROPERTY_NAME
-
-/* Strip whitespace chars off end of given string, in place. Return s. */
-static char* rstrip(char* s)
+/* Return pointer past the last non-whitespace char of [s, end). */
+static const char* rskip(const char* s, const char* end)
 {
-    char* p = s + strlen(s);
-    while (p > s && isspace(*--p))
-        *p = '\0';
-    return s;
+    while (end > s && isspace(*(end - 1)))
+        end--;
+    return end;
 }
 
-/* Return pointer to first non-whitespace char in given string. */
-static char* lskip(const char* s)
+/* Return pointer to first non-whitespace char of [s, end), or end. */
+static const char* lskip(const char* s, const char* end)
 {
-    while (*s && isspace(*s))
+    while (s < end && isspace(*s))
         s++;
-    return (char*)s;
+    return s;
 }
 
-/* Return pointer to first char c or ';' comment in given string, or pointer to
-   null at end of string if neither found. ';' must be prefixed by a whitespace
-   character to register as a comment. */
-static char* find_char_or_comment(const char* s, char c)
+/* Return pointer to first char c or ';' comment in [s, end), or end if
+   neither found. ';' must be prefixed by a whitespace character to register
+   as a comment. */
+static const char* find_char_or_comment(const char* s, const char* end,
+                                        char c)
 {
     int was_whitespace = 0;
-    while (*s && *s != c && !(was_whitespace && (*s == ';' || *s == '#'))) {
+    while (s < end && *s != c &&
+           !(was_whitespace && (*s == ';' || *s == '#'))) {
         was_whitespace = isspace(*s);
         s++;
     }
-    return (char*)s;
+    return s;
 }
 
-static char* find_last_char_or_comment(const char* s, char c)
+/* Return pointer to last char c before any comment in [s, end), or s if not
+   found. */
+static const char* find_last_char_or_comment(const char* s, const char* end,
+                                             char c)
 {
     const char* last_char = s;
     int was_whitespace = 0;
-    while (*s && !(was_whitespace && (*s == ';' || *s == '#'))) {
+    while (s < end && !(was_whitespace && (*s == ';' || *s == '#'))) {
         if (*s == c)
             last_char = s;
         was_whitespace = isspace(*s);
         s++;
     }
-    return (char*)last_char;
-}
-
-/* Version of strncpy that ensures dest (size bytes) is null-terminated. */
-static char* strncpy0(char* dest, const char* src, size_t size)
-{
-    strncpy(dest, src, size);
-    dest[size - 1] = '\0';
-    return dest;
+    return last_char;
 }
 
 /* See documentation in header file. */
 EDITORCONFIG_LOCAL
-int ini_parse_file(FILE* file,
-                   int (*handler)(void*, const char*, const char*,
-                                  const char*),
-                   void* user)
+int ini_parse_buffer(const char* buffer, size_t size,
+                     ini_slice_handler handler, void* user)
 {
-    /* Uses a fair bit of stack (use heap instead if you need to) */
-    char line[MAX_LINE];
-    char section[MAX_SECTION] = "";
-    char prev_name[MAX_NAME] = "";
-
-    char* start;
-    char* end;
-    char* name;
-    char* value;
+    const char* buffer_end = buffer + size;
+    const char* line = buffer;
+    ini_slice section = { "", 0 };
+#if INI_ALLOW_MULTILINE
+    ini_slice prev_name = { "", 0 };
+#endif
+
+    const char* line_end;
+    const char* next_line;
+    const char* start;
+    const char* end;
+    ini_slice name;
+    ini_slice value;
     int lineno = 0;
     int error = 0;
 
-    /* Scan through file line by line */
-    while (fgets(line, sizeof(line), file) != NULL) {
+    /* Scan through buffer line by line */
+    for (; line < buffer_end; line = next_line) {
+        line_end = (const char*)memchr(line, '\n', buffer_end - line);
+        next_line = line_end ? line_end + 1 : buffer_end;
+        if (!line_end)
+            line_end = buffer_end;
+        /* As in a C string, a null char ends the line */
+        end = (const char*)memchr(line, '\0', line_end - line);
+        if (end)
+            line_end = end;
         lineno++;
 
         start = line;
 #if INI_ALLOW_BOM
-        if (lineno == 1 && (unsigned char)start[0] == 0xEF &&
+        if (lineno == 1 && line_end - start >= 3 &&
+                           (unsigned char)start[0] == 0xEF &&
                            (unsigned char)start[1] == 0xBB &&
                            (unsigned char)start[2] == 0xBF) {
             start += 3;
         }
 #endif
-        start = lskip(rstrip(start));
+        line_end = rskip(start, line_end);
+        start = lskip(start, line_end);
 
-        if (*start == ';' || *start == '#') {
+        if (start == line_end) {
+            /* Blank line */
+        }
+        else if (*start == ';' || *start == '#') {
             /* Per Python ConfigParser, allow '#' comments at start of line */
         }
 #if INI_ALLOW_MULTILINE
-        else if (*prev_name && *start && start > line) {
+        else if (prev_name.len > 0 && start > line) {
             /* Non-black line with leading whitespace, treat as continuation
                of previous name's value (as per Python ConfigParser). */
-            if (!handler(user, section, prev_name, start) && !error)
+            value.str = start;
+            value.len = line_end - start;
+            if (!handler(user, &section, &prev_name, &value) && !error)
                 error = lineno;
         }
 #endif
         else if (*start == '[') {
             /* A "[section]" line */
-            end = find_last_char_or_comment(start + 1, ']');
-            if (*end == ']') {
-                *end = '\0';
-                strncpy0(section, start + 1, sizeof(section));
-                *prev_name = '\0';
+            end = find_last_char_or_comment(start + 1, line_end, ']');
+            if (end < line_end && *end == ']') {
+                section.str = start + 1;
+                section.len = end - (start + 1);
+#if INI_ALLOW_MULTILINE
+                prev_name.len = 0;
+#endif
             }
             else if (!error) {
                 /* No ']' found on section line */
                 error = lineno;
             }
         }
-        else if (*start && (*start != ';' || *start == '#')) {
+        else {
             /* Not a comment, must be a name[=:]value pair */
-            end = find_char_or_comment(start, '=');
-            if (*end != '=') {
-                end = find_char_or_comment(start, ':');
+            end = find_char_or_comment(start, line_end, '=');
+            if (end == line_end || *end != '=') {
+                end = find_char_or_comment(start, line_end, ':');
             }
-            if (*end == '=' || *end == ':') {
-                *end = '\0';
-                name = rstrip(start);
-                value = lskip(end + 1);
-                end = find_char_or_comment(value, '\0');
-                if (*end == ';' || *end == '#')
-                    *end = '\0';
-                rstrip(value);
+            if (end < line_end && (*end == '=' || *end == ':')) {
+                name.str = start;
+                name.len = rskip(start, end) - start;
+                value.str = lskip(end + 1, line_end);
+                end = find_char_or_comment(value.str, line_end, '\0');
+                value.len = rskip(value.str, end) - value.str;
 
                 /* Valid name[=:]value pair found, call handler */
-                strncpy0(prev_name, name, sizeof(prev_name));
-                if (!handler(user, section, name, value) && !error)
+#if INI_ALLOW_MULTILINE
+                prev_name = name;
+#endif
+                if (!handler(user, &section, &name, &value) && !error)
                     error = lineno;
             }
             else if (!error) {
@@ -182,6 +193,101 @@ int ini_parse_file(FILE* file,
     return error;
 }
 
+/* See documentation in header file. */
+EDITORCONFIG_LOCAL
+int ini_parse_stream(FILE* file, ini_slice_handler handler, void* user)
+{
+    char* buffer = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    int error;
+
+    /* Most files fit in the first read */
+    while (!feof(file)) {
+        if (size == capacity) {
+            size_t new_capacity = capacity ? 2 * capacity : 4096;
+            char* new_buffer = (char*)realloc(buffer, new_capacity);
+
+            if (!new_buffer) {
+                free(buffer);
+                return -2;
+            }
+            buffer = new_buffer;
+            capacity = new_capacity;
+        }
+
+        size += fread(buffer + size, 1, capacity - size, file);
+        if (ferror(file)) {
+            free(buffer);
+            return -2;
+        }
+    }
+
+    error = ini_parse_buffer(buffer, size, handler, user);
+    free(buffer);
+    return error;
+}
+
+/* the user pointer of copy_handler() */
+typedef struct
+{
+    int (*handler)(void*, const char*, const char*, const char*);
+    void* user;
+    char* strings;  /* null-terminated copies of section, name and value */
+    size_t capacity;
+} copy_param;
+
+/* Call a null-terminated string handler with copies of the slices */
+static int copy_handler(void* user, const ini_slice* section,
+                        const ini_slice* name, const ini_slice* value)
+{
+    copy_param* cp = (copy_param*)user;
+    size_t size = section->len + name->len + value->len + 3;
+    char* s;
+    char* n;
+    char* v;
+
+    if (size > cp->capacity) {
+        char* new_strings = (char*)realloc(cp->strings, 2 * size);
+
+        if (!new_strings)
+            return 0;
+        cp->strings = new_strings;
+        cp->capacity = 2 * size;
+    }
+
+    s = cp->strings;
+    memcpy(s, section->str, section->len);
+    s[section->len] = '\0';
+    n = s + section->len + 1;
+    memcpy(n, name->str, name->len);
+    n[name->len] = '\0';
+    v = n + name->len + 1;
+    memcpy(v, value->str, value->len);
+    v[value->len] = '\0';
+
+    return cp->handler(cp->user, s, n, v);
+}
+
+/* See documentation in header file. */
+EDITORCONFIG_LOCAL
+int ini_parse_file(FILE* file,
+                   int (*handler)(void*, const char*, const char*,
+                                  const char*),
+                   void* user)
+{
+    copy_param cp;
+    int error;
+
+    cp.handler = handler;
+    cp.user = user;
+    cp.strings = NULL;
+    cp.capacity = 0;
+    error = ini_parse_stream(file, copy_handler, &cp);
+    free(cp.strings);
+    return error;
+}
+
 /* See documentation in header file. */
 EDITORCONFIG_LOCAL
 int ini_parse(const char* filename,
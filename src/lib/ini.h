@@ -63,13 +63,40 @@ int ini_parse(const char* filename,
               void* user);
 
 /* Same as ini_parse(), but takes a FILE* instead of filename. This doesn't
-   close the file when it's finished -- the caller must do that. */
+   close the file when it's finished -- the caller must do that. Returns -2 if
+   the file could not be read into memory. */
 EDITORCONFIG_LOCAL
 int ini_parse_file(FILE* file,
                    int (*handler)(void* user, const char* section,
                                   const char* name, const char* value),
                    void* user);
 
+/* A string of len chars inside the parsed data, not null-terminated. */
+typedef struct ini_slice
+{
+    const char* str;
+    size_t len;
+} ini_slice;
+
+/* Handler of ini_parse_buffer() and ini_parse_stream(). section, name and
+   value point into the parsed data, so they are only valid as long as it is.
+   Handler should return nonzero on success, zero on error. */
+typedef int (*ini_slice_handler)(void* user, const ini_slice* section,
+                                 const ini_slice* name,
+                                 const ini_slice* value);
+
+/* Same as ini_parse(), but parses the size bytes of buffer in place, without
+   copying them, and without any limit on the length of the lines. */
+EDITORCONFIG_LOCAL
+int ini_parse_buffer(const char* buffer, size_t size,
+                     ini_slice_handler handler, void* user);
+
+/* Read the whole file into memory at once and parse it with
+   ini_parse_buffer(). Returns -2 if the file could not be read or memory runs
+   out. This doesn't close the file -- the caller must do that. */
+EDITORCONFIG_LOCAL
+int ini_parse_stream(FILE* file, ini_slice_handler handler, void* user);
+
 /* Nonzero to allow multi-line value parsing, in the style of Python's
    ConfigParser. If allowed, ini_parse() will call the handler with the same
    name for each subsequent line parsed. */
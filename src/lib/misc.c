@@ -248,3 +248,19 @@ _Bool is_file_path_absolute(const char* path)
 # error "Either UNIX or WIN32 must be defined."
 #endif
 }
+
+/*
+ * FNV-1a hash of a string, used to index the internal caches
+ */
+EDITORCONFIG_LOCAL
+unsigned int ec_str_hash(const char* str)
+{
+    unsigned int        hash = 2166136261u;
+
+    for (; *str; ++str) {
+        hash ^= (unsigned char)*str;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
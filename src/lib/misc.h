@@ -59,4 +59,6 @@ char* ec_strlwr(char* str);
 #endif
 EDITORCONFIG_LOCAL
 _Bool is_file_path_absolute(const char* path);
+EDITORCONFIG_LOCAL
+unsigned int ec_str_hash(const char* str);
 #endif /* __MISC_H__ */